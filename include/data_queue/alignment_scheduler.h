@@ -0,0 +1,166 @@
+#pragma once
+#include "thread_pool.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <vector>
+
+namespace daqu
+{
+  /// \brief run consumer callbacks as soon as all of their input streams cover a timestamp
+  ///
+  /// Producers commit the watermark of a stream, the latest timestamp they appended, i.e.
+  /// in_range(ts) holds for every ts up to it. A consumer requests timestamps and its callback
+  /// is dispatched on the pool once the minimum watermark of its inputs reached them.
+  /// Callbacks of one consumer run one at a time in timestamp order.
+  template <typename timeT>
+  class alignment_scheduler
+  {
+  public:
+    using stream_id   = std::size_t;
+    using consumer_id = std::size_t;
+    using callback    = std::function<void(const timeT&)>;
+
+    explicit alignment_scheduler(thread_pool& pool) : _pool(pool) {}
+
+    alignment_scheduler(const alignment_scheduler&) = delete;
+    alignment_scheduler& operator=(const alignment_scheduler&) = delete;
+
+    /// \brief wait for dispatched callbacks
+    ~alignment_scheduler()
+    {
+      std::unique_lock<std::mutex> lock(_m);
+      _idle.wait(lock, [this]() { return _active == 0; });
+    }
+
+    stream_id add_stream()
+    {
+      std::lock_guard<std::mutex> lock(_m);
+      _streams.emplace_back();
+      return _streams.size() - 1;
+    }
+
+    consumer_id add_consumer(const std::vector<stream_id>& inputs, callback cb)
+    {
+      std::lock_guard<std::mutex> lock(_m);
+      const consumer_id id = _consumers.size();
+      _consumers.push_back({inputs, std::move(cb), {}, false});
+      for (stream_id s : inputs)
+        _streams[s].consumers.push_back(id);
+      return id;
+    }
+
+    /// \brief run callback of consumer with ts once all its inputs cover ts
+    void request(consumer_id c, const timeT& ts)
+    {
+      std::lock_guard<std::mutex> lock(_m);
+      _consumers[c].requests.push(ts);
+      dispatch_if_ready(c);
+    }
+
+    /// \brief advance watermark of stream, older watermarks are ignored
+    void commit(stream_id s, const timeT& watermark)
+    {
+      std::lock_guard<std::mutex> lock(_m);
+      auto& st = _streams[s];
+      if (st.watermark && *st.watermark >= watermark)
+        return;
+
+      st.watermark = watermark;
+      for (consumer_id c : st.consumers)
+        dispatch_if_ready(c);
+    }
+
+    std::optional<timeT> watermark(stream_id s) const
+    {
+      std::lock_guard<std::mutex> lock(_m);
+      return _streams[s].watermark;
+    }
+
+  private:
+    struct stream
+    {
+      std::optional<timeT>     watermark;
+      std::vector<consumer_id> consumers;
+    };
+
+    struct consumer
+    {
+      std::vector<stream_id>                                          inputs;
+      callback                                                        cb;
+      std::priority_queue<timeT, std::vector<timeT>, std::greater<>> requests;
+      bool                                                            running;
+    };
+
+    // called with _m locked
+    bool ready(const consumer& c) const
+    {
+      if (c.requests.empty())
+        return false;
+
+      for (stream_id s : c.inputs)
+      {
+        const auto& wm = _streams[s].watermark;
+        if (!wm || *wm < c.requests.top())
+          return false;
+      }
+      return true;
+    }
+
+    // called with _m locked
+    void dispatch_if_ready(consumer_id id)
+    {
+      consumer& c = _consumers[id];
+      if (c.running || !ready(c))
+        return;
+
+      c.running = true;
+      ++_active;
+      _pool.submit([this, id]() { run(id); });
+    }
+
+    void run(consumer_id id)
+    {
+      std::vector<timeT> batch;
+      for (;;)
+      {
+        callback* cb = nullptr;
+        {
+          std::lock_guard<std::mutex> lock(_m);
+          consumer&                   c = _consumers[id];
+          batch.clear();
+          while (ready(c))
+          {
+            batch.push_back(c.requests.top());
+            c.requests.pop();
+          }
+
+          if (batch.empty())
+          {
+            c.running = false;
+            if (--_active == 0)
+              _idle.notify_all();
+            return;
+          }
+          cb = &c.cb;
+        }
+
+        for (const timeT& ts : batch)
+          (*cb)(ts);
+      }
+    }
+
+    thread_pool&            _pool;
+    mutable std::mutex      _m;
+    std::condition_variable _idle;
+    std::size_t             _active = 0;
+    std::deque<stream>      _streams;
+    std::deque<consumer>    _consumers;
+  };
+
+} // namespace daqu
@@ -0,0 +1,214 @@
+#pragma once
+#include "types.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace daqu
+{
+  // override it for payloads which are not trivially copyable
+  // Example:
+  // namespace daqu {
+  //   template<>
+  //   bool write_payload(std::ostream &os, const std::string &s) {
+  //      const std::uint64_t n = s.size();
+  //      return os.write(reinterpret_cast<const char*>(&n), sizeof(n)) && os.write(s.data(), n);
+  //   }
+  //   template<>
+  //   bool read_payload(std::istream &is, std::string &s) {
+  //      std::uint64_t n = 0;
+  //      if (!is.read(reinterpret_cast<char*>(&n), sizeof(n))) return false;
+  //      s.resize(n);
+  //      return bool(is.read(s.data(), n));
+  //   }
+  // }
+  /// \brief write payload to checkpoint stream
+  template <typename T>
+  bool write_payload(std::ostream& os, const T& value)
+  {
+    static_assert(std::is_trivially_copyable_v<T>, "specialize daqu::write_payload for this payload type.");
+    return static_cast<bool>(os.write(reinterpret_cast<const char*>(&value), sizeof(T)));
+  }
+
+  /// \brief read payload from checkpoint stream
+  template <typename T>
+  bool read_payload(std::istream& is, T& value)
+  {
+    static_assert(std::is_trivially_copyable_v<T>, "specialize daqu::read_payload for this payload type.");
+    return static_cast<bool>(is.read(reinterpret_cast<char*>(&value), sizeof(T)));
+  }
+
+  enum class checkpoint_status
+  {
+    success = 0,
+    io_error,
+    bad_format
+  };
+
+  namespace detail
+  {
+    struct checkpoint_header
+    {
+      char          magic[4];
+      std::uint32_t version;
+      std::uint32_t raw;          // elements stored as one memory image
+      std::uint32_t element_size; // sizeof(value_type) for raw images
+      std::uint64_t count;
+    };
+
+    constexpr char          checkpoint_magic[4] = {'D', 'A', 'Q', 'U'};
+    constexpr std::uint32_t checkpoint_version  = 1;
+
+    template <typename Container, typename = void>
+    struct is_contiguous : std::false_type
+    {
+    };
+
+    template <typename Container>
+    struct is_contiguous<Container, std::void_t<decltype(std::declval<Container&>().data())>> : std::true_type
+    {
+    };
+
+    template <typename Container>
+    constexpr bool checkpoint_raw_v = std::is_trivially_copyable_v<typename Container::value_type>;
+
+    template <typename Container, typename Iterator>
+    checkpoint_status write_checkpoint(Iterator first, Iterator last, const std::string& path)
+    {
+      using value_type = typename Container::value_type;
+      static_assert(std::is_same_v<typename value_type::stamped_data_category, daqu::stamped_data_category_tag>,
+                    "works only with daqu::stamped_data type.");
+      static_assert(std::is_trivially_copyable_v<typename value_type::time_value_type>, "timestamps are stored as memory image.");
+
+      // write next to the target and rename, a crash mid-save keeps the previous checkpoint
+      const std::string tmp = path + ".tmp";
+      std::ofstream     os(tmp, std::ios::binary | std::ios::trunc);
+      if (!os)
+        return checkpoint_status::io_error;
+
+      checkpoint_header header{};
+      std::memcpy(header.magic, checkpoint_magic, sizeof(header.magic));
+      header.version      = checkpoint_version;
+      header.raw          = checkpoint_raw_v<Container>;
+      header.element_size = sizeof(value_type);
+      header.count        = static_cast<std::uint64_t>(std::distance(first, last));
+      os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+      if constexpr (checkpoint_raw_v<Container> && is_contiguous<Container>::value)
+      {
+        if (first != last)
+          os.write(reinterpret_cast<const char*>(&*first), static_cast<std::streamsize>(header.count * sizeof(value_type)));
+      }
+      else
+      {
+        for (; first != last && os; ++first)
+        {
+          if constexpr (checkpoint_raw_v<Container>)
+            os.write(reinterpret_cast<const char*>(&*first), sizeof(value_type));
+          else if (!write_payload(os, first->data) || !os.write(reinterpret_cast<const char*>(&first->ts), sizeof(first->ts)))
+            os.setstate(std::ios::failbit);
+        }
+      }
+
+      os.close();
+      if (!os)
+      {
+        std::remove(tmp.c_str());
+        return checkpoint_status::io_error;
+      }
+
+      // rename does not replace an existing file on every platform
+      if (std::rename(tmp.c_str(), path.c_str()) != 0 && (std::remove(path.c_str()) != 0 || std::rename(tmp.c_str(), path.c_str()) != 0))
+      {
+        std::remove(tmp.c_str());
+        return checkpoint_status::io_error;
+      }
+      return checkpoint_status::success;
+    }
+  } // namespace detail
+
+  /// \brief write whole buffer to binary file at path
+  ///
+  /// Trivially copyable samples of contiguous buffers are written as one memory image and
+  /// restored with one read, so the file is only portable between identical builds.
+  /// The file is written to path + ".tmp" first and renamed to path once complete.
+  template <typename Container>
+  checkpoint_status save_checkpoint(const Container& buff, const std::string& path)
+  {
+    return detail::write_checkpoint<Container>(buff.begin(), buff.end(), path);
+  }
+
+  /// \brief write samples with timestamp equal or greater than since
+  template <typename Container>
+  checkpoint_status save_checkpoint(const Container& buff, const std::string& path, const typename Container::value_type::time_value_type& since)
+  {
+    using value_type = typename Container::value_type;
+    auto first       = std::lower_bound(buff.begin(), buff.end(), since, [](const value_type& a, const auto& b) { return a.ts < b; });
+    return detail::write_checkpoint<Container>(first, buff.end(), path);
+  }
+
+  /// \brief replace buffer content with checkpoint stored at path
+  template <typename Container>
+  checkpoint_status load_checkpoint(Container& buff, const std::string& path)
+  {
+    using value_type = typename Container::value_type;
+
+    std::ifstream is(path, std::ios::binary);
+    if (!is)
+      return checkpoint_status::io_error;
+
+    detail::checkpoint_header header{};
+    if (!is.read(reinterpret_cast<char*>(&header), sizeof(header)))
+      return checkpoint_status::bad_format;
+
+    if (std::memcmp(header.magic, detail::checkpoint_magic, sizeof(header.magic)) != 0 || header.version != detail::checkpoint_version
+        || header.raw != detail::checkpoint_raw_v<Container> || (header.raw && header.element_size != sizeof(value_type)))
+      return checkpoint_status::bad_format;
+
+    // count must fit into the rest of the file before anything is allocated for it
+    const auto body = is.tellg();
+    is.seekg(0, std::ios::end);
+    const auto bytes = static_cast<std::uint64_t>(is.tellg() - body);
+    is.seekg(body);
+    const std::uint64_t min_element_size = header.raw ? sizeof(value_type) : sizeof(typename value_type::time_value_type);
+    if (!is || header.count > bytes / min_element_size)
+      return checkpoint_status::bad_format;
+
+    buff.clear();
+
+    if constexpr (detail::checkpoint_raw_v<Container> && detail::is_contiguous<Container>::value)
+    {
+      buff.resize(static_cast<typename Container::size_type>(header.count));
+      if (header.count != 0)
+        is.read(reinterpret_cast<char*>(buff.data()), static_cast<std::streamsize>(header.count * sizeof(value_type)));
+    }
+    else
+    {
+      for (std::uint64_t i = 0; i < header.count && is; ++i)
+      {
+        value_type v;
+        if constexpr (detail::checkpoint_raw_v<Container>)
+          is.read(reinterpret_cast<char*>(&v), sizeof(value_type));
+        else if (!read_payload(is, v.data) || !is.read(reinterpret_cast<char*>(&v.ts), sizeof(v.ts)))
+          is.setstate(std::ios::failbit);
+
+        if (is)
+          buff.push_back(std::move(v));
+      }
+    }
+
+    if (!is)
+    {
+      buff.clear();
+      return checkpoint_status::bad_format;
+    }
+    return checkpoint_status::success;
+  }
+
+} // namespace daqu
@@ -0,0 +1,137 @@
+#pragma once
+#include "data_queue.h"
+#include <chrono>
+#include <cstddef>
+#include <ratio>
+#include <type_traits>
+
+namespace daqu
+{
+  /// \brief online linear estimate target = offset + drift * source between two clocks
+  ///
+  /// Feed pairs of simultaneous stamps with add(). Older pairs are down-weighted by the
+  /// forgetting factor, so a factor below 1 tracks a drift that changes over time.
+  /// Works with std::chrono::time_point like types.
+  template <typename SourceTime, typename TargetTime>
+  class clock_mapping
+  {
+  public:
+    using source_time_type = SourceTime;
+    using target_time_type = TargetTime;
+
+    explicit clock_mapping(double forgetting = 1.) : _forgetting(forgetting) {}
+
+    /// \brief add observation of the same instant stamped by both clocks
+    void add(const SourceTime& src, const TargetTime& dst) noexcept
+    {
+      if (_count == 0)
+      {
+        _src0 = src;
+        _dst0 = dst;
+      }
+
+      const double x = to_double(src - _src0);
+      const double y = to_double(dst - _dst0);
+
+      // exponentially weighted means and co-moments, stable for long runs
+      _weight         = _forgetting * _weight + 1.;
+      const double dx = x - _mean_x;
+      _mean_x += dx / _weight;
+      _mean_y += (y - _mean_y) / _weight;
+      _cxx = _forgetting * _cxx + dx * (x - _mean_x);
+      _cxy = _forgetting * _cxy + dx * (y - _mean_y);
+
+      ++_count;
+    }
+
+    bool        valid() const noexcept { return _count > 0; }
+    std::size_t observations() const noexcept { return _count; }
+
+    /// \brief target ticks per source tick, nominal ratio of periods until two stamps are known
+    double drift() const noexcept { return _cxx > 0. ? _cxy / _cxx : nominal_drift(); }
+
+    TargetTime to_target(const SourceTime& src) const noexcept
+    {
+      const double y = _mean_y + drift() * (to_double(src - _src0) - _mean_x);
+      return _dst0 + std::chrono::round<typename TargetTime::duration>(std::chrono::duration<double, typename TargetTime::period>(y));
+    }
+
+    SourceTime to_source(const TargetTime& dst) const noexcept
+    {
+      const double x = _mean_x + (to_double(dst - _dst0) - _mean_y) / drift();
+      return _src0 + std::chrono::round<typename SourceTime::duration>(std::chrono::duration<double, typename SourceTime::period>(x));
+    }
+
+  private:
+    template <typename Duration>
+    static double to_double(const Duration& d)
+    {
+      return static_cast<double>(d.count());
+    }
+
+    static double nominal_drift()
+    {
+      using ratio = std::ratio_divide<typename SourceTime::period, typename TargetTime::period>;
+      return static_cast<double>(ratio::num) / static_cast<double>(ratio::den);
+    }
+
+    double      _forgetting;
+    std::size_t _count = 0;
+    SourceTime  _src0{};
+    TargetTime  _dst0{};
+    double      _weight = 0.;
+    double      _mean_x = 0.;
+    double      _mean_y = 0.;
+    double      _cxx    = 0.;
+    double      _cxy    = 0.;
+  };
+
+  /// \brief accessor taking query stamps in the target domain of mapping
+  ///
+  /// Stored samples stay in their own clock, every query stamp is translated with the
+  /// current estimate of mapping, so updating the estimate never rewrites the buffer.
+  /// Returned samples, time_diff and max_ts_diff are in the source clock.
+  template <typename Container, typename Mapping>
+  class clock_domain_accessor
+  {
+  public:
+    using accessor_type              = storage_data_accessor<Container>;
+    using iterator                   = typename accessor_type::iterator;
+    using value_type                 = typename accessor_type::value_type;
+    using data_value_type            = typename accessor_type::data_value_type;
+    using time_value_type            = typename Mapping::target_time_type;
+    using difference_time_value_type = typename accessor_type::difference_time_value_type;
+
+    static_assert(std::is_same_v<typename accessor_type::time_value_type, typename Mapping::source_time_type>,
+                  "mapping source clock must match buffer clock.");
+
+    clock_domain_accessor(Container& buff, const Mapping& mapping) : _access(buff), _mapping(mapping){};
+
+    iterator get(const time_value_type& ts) const noexcept { return _access.get(_mapping.to_source(ts)); }
+
+    auto get(const time_value_type& target_ts, const difference_time_value_type& max_ts_diff) const noexcept
+    {
+      return _access.get(_mapping.to_source(target_ts), max_ts_diff);
+    }
+
+    bool in_range(const time_value_type& target_ts) const noexcept { return _access.in_range(_mapping.to_source(target_ts)); }
+
+    template <typename Interpolation = detail::default_interpolation_data<data_value_type, typename Mapping::source_time_type>>
+    value_type get_data_inter(const iterator& iter, const time_value_type& target_ts, Interpolation interpolation = {}) const noexcept
+    {
+      return _access.get_data_inter(iter, _mapping.to_source(target_ts), interpolation);
+    }
+
+  private:
+    accessor_type  _access;
+    const Mapping& _mapping;
+  };
+
+  /// \brief access buffer with query stamps expressed in the target clock of mapping
+  template <typename Container, typename Mapping>
+  auto access_in(Container& container, const Mapping& mapping)
+  {
+    return clock_domain_accessor<Container, Mapping>(container, mapping);
+  }
+
+} // namespace daqu
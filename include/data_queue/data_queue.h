@@ -1,7 +1,14 @@
 #pragma once
 #include "types.h"
 #include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <tuple>
 #include <type_traits>
+#include <utility>
 
 namespace daqu
 {
@@ -37,7 +44,19 @@ namespace daqu
     success = 0,
     timestamp_diff_larger_then_thresh,
     not_enough_elements,
-    timestamp_unorder
+    timestamp_unorder,
+    deadline_exceeded,                // deadline passed before the query, nearest sample returned without interpolation
+    interpolation_skipped_by_deadline // nearest sample returned without interpolation
+  };
+
+  /// \brief time budget of a query
+  template <typename Clock = std::chrono::steady_clock>
+  struct deadline
+  {
+    typename Clock::time_point until;
+    typename Clock::duration   interpolation_cost{}; // expected run time of interpolation functor
+
+    bool expired(const typename Clock::duration& work = {}) const noexcept { return Clock::now() + work >= until; }
   };
 
   template <typename timeT>
@@ -46,7 +65,45 @@ namespace daqu
     return (a > b ? a - b : b - a);
   }
 
-  template <typename Container>
+  /// \brief default search policy: binary search over the whole container
+  /// A search policy returns the first element with timestamp equal or greater than ts.
+  struct lower_bound_search
+  {
+    template <typename Container, typename timeT>
+    auto operator()(Container& storage, const timeT& ts) const
+    {
+      return std::lower_bound(storage.begin(), storage.end(), ts, [](const auto& a, const timeT& b) { return a.ts < b; });
+    }
+  };
+
+  /// \brief branchless binary search prefetching both possible next probes
+  /// Hides part of the cache and TLB misses of searches in buffers much larger than the caches.
+  /// Requires random access iterators.
+  struct prefetch_search
+  {
+    template <typename Container, typename timeT>
+    auto operator()(Container& storage, const timeT& ts) const
+    {
+      auto           base = storage.begin();
+      std::ptrdiff_t n    = std::distance(storage.begin(), storage.end());
+      if (n == 0)
+        return base;
+
+      while (n > 1)
+      {
+        const std::ptrdiff_t half = n / 2;
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(&*(base + half / 2));
+        __builtin_prefetch(&*(base + half + half / 2));
+#endif
+        base = (base + half)->ts < ts ? base + half : base;
+        n -= half;
+      }
+      return base->ts < ts ? base + 1 : base;
+    }
+  };
+
+  template <typename Container, typename Search = lower_bound_search>
   class storage_data_accessor
   {
 
@@ -68,13 +125,267 @@ namespace daqu
       storage_access_status      status;
     };
 
-    storage_data_accessor(Container& buff) : _storage(buff){};
+    struct data_result
+    {
+      value_type            value;
+      iterator              it; // nearest sample or left sample of interpolation
+      storage_access_status status;
+    };
+
+    /// \brief contiguous run of the k samples nearest to a timestamp
+    struct window
+    {
+      iterator                   first;     // first sample of the window
+      iterator                   last;      // one past the last sample of the window
+      iterator                   nearest;   // same sample get(ts) returns
+      difference_time_value_type time_diff; // distance from ts to nearest
+      storage_access_status      status;
+    };
+
+    /// \brief samples bracketing a timestamp with precomputed interpolation weights
+    struct bracket
+    {
+      iterator              first; // up to k samples on each side of ts
+      iterator              last;
+      iterator              left;  // left == right on exact hit or outside of the buffer
+      iterator              right;
+      float                 w0;
+      float                 w1;
+      time_value_type       ts;
+      storage_access_status status;
+    };
+
+    /// \brief stored sample by reference, or interpolated value when interpolation was needed
+    class data_ref
+    {
+    public:
+      explicit data_ref(const value_type& sample) noexcept : _sample(&sample) {}
+      explicit data_ref(value_type&& value) : _value(std::move(value)) {}
+
+      const value_type& get() const noexcept { return _value ? *_value : *_sample; }
+      const value_type& operator*() const noexcept { return get(); }
+      const value_type* operator->() const noexcept { return &get(); }
+
+      bool interpolated() const noexcept { return _value.has_value(); }
+
+    private:
+      const value_type*         _sample = nullptr;
+      std::optional<value_type> _value;
+    };
+
+    storage_data_accessor(Container& buff, Search search = {}) : _storage(buff), _search(search){};
 
     /// \brief return iter with equal or greater timestamp
-    iterator get(const time_value_type& ts) const noexcept
+    iterator get(const time_value_type& ts) const noexcept { return nearest(lower_bound(ts), ts); }
+
+    auto get(const time_value_type& target_ts, const difference_time_value_type& max_ts_diff) const noexcept
     {
-      iterator it = std::lower_bound(_storage.begin(), _storage.end(), ts, [](const value_type& a, const time_value_type& b) { return a.ts < b; });
+      return make_result(get(target_ts), target_ts, max_ts_diff);
+    }
+
+    /// \brief get(ts, max_ts_diff) for every timestamp of [ts_first, ts_last) written to out
+    /// Ascending timestamps share the search: it resumes with a galloping search from the previous hit.
+    template <typename InputIt, typename OutputIt>
+    OutputIt get(InputIt ts_first, InputIt ts_last, const difference_time_value_type& max_ts_diff, OutputIt out) const noexcept
+    {
+      iterator        lb = _storage.begin();
+      time_value_type prev{};
+      for (bool sorted = false; ts_first != ts_last; ++ts_first, sorted = true)
+      {
+        const time_value_type& ts = *ts_first;
+        lb                        = sorted && !(ts < prev) ? gallop(lb, ts) : lower_bound(ts);
+        prev                      = ts;
+        *out++                    = make_result(nearest(lb, ts), ts, max_ts_diff);
+      }
+      return out;
+    }
+
+    bool in_range(const time_value_type& target_ts) const noexcept
+    {
+      return _storage.size() > 2 && target_ts <= (last())->ts && target_ts >= (_storage.begin())->ts;
+    }
+
+    /// \brief in_range for every timestamp of [ts_first, ts_last), bit i % 64 of mask word i / 64
+    template <typename InputIt, typename OutputIt>
+    OutputIt in_range(InputIt ts_first, InputIt ts_last, OutputIt mask) const noexcept
+    {
+      const bool      enough = _storage.size() > 2;
+      time_value_type lo{}, hi{};
+      if (enough)
+      {
+        lo = _storage.begin()->ts;
+        hi = (last())->ts;
+      }
+
+      while (ts_first != ts_last)
+      {
+        // branchless block of 64 comparisons
+        std::uint64_t word = 0;
+        for (unsigned bit = 0; bit < 64 && ts_first != ts_last; ++bit, ++ts_first)
+          word |= static_cast<std::uint64_t>(enough & !(*ts_first < lo) & !(hi < *ts_first)) << bit;
+        *mask++ = word;
+      }
+      return mask;
+    }
+
+    /// \brief return the k samples nearest to ts found with a single search
+    window get_nearest(const time_value_type& ts, std::size_t k) const noexcept
+    {
+      window res{_storage.end(), _storage.end(), _storage.end(), {}, storage_access_status::not_enough_elements};
+      if (_storage.empty() || k == 0)
+        return res;
+
+      iterator l = lower_bound(ts);
+      iterator r = l;
+
+      // grow [l, r) towards the closer side, ties go right as in get(ts)
+      const std::size_t n = std::min<std::size_t>(k, _storage.size());
+      for (std::size_t i = 0; i < n; ++i)
+      {
+        bool take_left = r == _storage.end();
+        if (!take_left && l != _storage.begin())
+          take_left = time_adiff(std::prev(l)->ts, ts) < time_adiff(r->ts, ts);
+
+        if (take_left)
+          --l;
+        if (i == 0)
+          res.nearest = take_left ? l : r;
+        if (!take_left)
+          ++r;
+      }
+
+      res.first     = l;
+      res.last      = r;
+      res.time_diff = time_adiff(res.nearest->ts, ts);
+      res.status    = n == k ? storage_access_status::success : storage_access_status::not_enough_elements;
+      return res;
+    }
+
+    /// \brief return up to k samples on each side of ts and the weights of the inner pair
+    /// status is success when all of them exist, not_enough_elements for ts outside of the buffer.
+    bracket get_bracket(const time_value_type& ts, std::size_t k = 1) const noexcept
+    {
+      bracket res{_storage.end(), _storage.end(), _storage.end(), _storage.end(), 0.f, 1.f, ts, storage_access_status::not_enough_elements};
+      if (_storage.empty() || k == 0)
+        return res;
+
+      iterator r = lower_bound(ts);
+      if (r == _storage.end())
+        res.left = res.right = last();
+      else if (r->ts == ts || r == _storage.begin())
+        res.left = res.right = r;
+      else
+      {
+        res.left  = std::prev(r);
+        res.right = r;
+        std::tie(res.w0, res.w1) = weights(res.left, res.right, ts);
+      }
 
+      const auto before = std::min<std::size_t>(k - 1, static_cast<std::size_t>(std::distance(_storage.begin(), res.left)));
+      const auto after  = std::min<std::size_t>(k, static_cast<std::size_t>(std::distance(res.right, _storage.end())));
+      res.first         = std::prev(res.left, static_cast<std::ptrdiff_t>(before));
+      res.last          = std::next(res.right, static_cast<std::ptrdiff_t>(after));
+
+      // exact hits need k - 1 samples on each side of the hit, edge clamps never succeed
+      const bool inside   = res.left != res.right || res.left->ts == ts;
+      const bool complete = inside && before == k - 1 && after == k;
+      res.status          = complete ? storage_access_status::success : storage_access_status::not_enough_elements;
+      return res;
+    }
+
+    /// \brief interpolate with the weights already computed by get_bracket
+    template <typename Interpolation = detail::default_interpolation_data<data_value_type, time_value_type>>
+    value_type get_data_inter(const bracket& b, Interpolation interpolation = {}) const noexcept
+    {
+      if (b.left == b.right)
+        return *b.left;
+
+      return interpolation(*b.left, b.w0, *b.right, b.w1, b.ts);
+    }
+
+    /// \brief search and interpolate, degrade to the nearest sample if interpolation does not fit into the deadline
+    /// The search is O(log n) and always done, a deadline passed before the call only skips interpolation.
+    /// Stamps outside the buffer return the edge sample with not_enough_elements.
+    template <typename Clock, typename Interpolation = detail::default_interpolation_data<data_value_type, time_value_type>>
+    data_result get_data_inter(const time_value_type& target_ts, const deadline<Clock>& dl, Interpolation interpolation = {}) const noexcept
+    {
+      const bool late = dl.expired();
+
+      data_result   res{{}, _storage.end(), storage_access_status::not_enough_elements};
+      const bracket b = get_bracket(target_ts);
+      if (b.left == _storage.end())
+        return res;
+
+      res.status = late ? storage_access_status::deadline_exceeded : storage_access_status::success;
+      if (b.left == b.right)
+      {
+        res.it     = b.left;
+        res.value  = *b.left;
+        res.status = b.status == storage_access_status::success ? res.status : b.status;
+      }
+      else if (late || dl.expired(dl.interpolation_cost))
+      {
+        // same tie break as get(ts)
+        res.it     = b.w0 < b.w1 ? b.left : b.right;
+        res.value  = *res.it;
+        res.status = late ? storage_access_status::deadline_exceeded : storage_access_status::interpolation_skipped_by_deadline;
+      }
+      else
+      {
+        res.it    = b.left;
+        res.value = get_data_inter(b, interpolation);
+      }
+      return res;
+    }
+
+    template <typename Interpolation = detail::default_interpolation_data<data_value_type, time_value_type>>
+    value_type get_data_inter(const iterator& iter, const time_value_type& target_ts, Interpolation interpolation = {}) const noexcept
+    {
+      const auto [l, r] = neighbours(iter, target_ts);
+      if (l == r)
+        return *l;
+
+      const auto [w0, w1] = weights(l, r, target_ts);
+      return interpolation(*l, w0, *r, w1, target_ts);
+    }
+
+    /// \brief get_data_inter without copying the stored sample when no interpolation is needed
+    template <typename Interpolation = detail::default_interpolation_data<data_value_type, time_value_type>>
+    data_ref get_data_ref(const iterator& iter, const time_value_type& target_ts, Interpolation interpolation = {}) const
+    {
+      const auto [l, r] = neighbours(iter, target_ts);
+      if (l == r)
+        return data_ref(*l);
+
+      const auto [w0, w1] = weights(l, r, target_ts);
+      return data_ref(interpolation(*l, w0, *r, w1, target_ts));
+    }
+
+    /// \brief get_data_inter into a caller provided sample, reusing the payload storage of out
+    /// Interpolation may take out as sixth argument (l, w0, r, w1, ts, out) and write into it,
+    /// otherwise its result is assigned to out.
+    /// \return stored sample when no interpolation is needed, out otherwise
+    template <typename Interpolation = detail::default_interpolation_data<data_value_type, time_value_type>>
+    const value_type& get_data_inter_into(const iterator& iter, const time_value_type& target_ts, value_type& out,
+                                          Interpolation interpolation = {}) const
+    {
+      const auto [l, r] = neighbours(iter, target_ts);
+      if (l == r)
+        return *l;
+
+      const auto [w0, w1] = weights(l, r, target_ts);
+      if constexpr (std::is_invocable_v<Interpolation&, const value_type&, float, const value_type&, float, const time_value_type&, value_type&>)
+        interpolation(*l, w0, *r, w1, target_ts, out);
+      else
+        out = interpolation(*l, w0, *r, w1, target_ts);
+      return out;
+    }
+
+  private:
+    iterator last() const { return std::prev(_storage.end()); }
+
+    iterator nearest(iterator it, const time_value_type& ts) const noexcept
+    {
       if (it != _storage.end()) // found
       {
         if (it == _storage.begin())
@@ -93,10 +404,30 @@ namespace daqu
       return it;
     }
 
-    auto get(const time_value_type& target_ts, const difference_time_value_type& max_ts_diff) const noexcept
+    /// \brief lower bound of ts not before from, probing 1, 2, 4... elements ahead first
+    iterator gallop(iterator from, const time_value_type& ts) const noexcept
     {
-      iterator closest = get(target_ts);
+      const auto less = [](const value_type& a, const time_value_type& b) { return a.ts < b; };
 
+      std::ptrdiff_t step = 1;
+      iterator       lo   = from;
+      for (;;)
+      {
+        const auto left = std::distance(lo, _storage.end());
+        if (left <= step)
+          return std::lower_bound(lo, _storage.end(), ts, less);
+
+        iterator hi = std::next(lo, step);
+        if (!less(*hi, ts))
+          return std::lower_bound(lo, hi, ts, less);
+
+        lo = hi;
+        step *= 2;
+      }
+    }
+
+    result make_result(const iterator& closest, const time_value_type& target_ts, const difference_time_value_type& max_ts_diff) const noexcept
+    {
       result res;
       res.it = closest;
 
@@ -120,44 +451,26 @@ namespace daqu
       return res;
     }
 
-    bool in_range(const time_value_type& target_ts) const noexcept
+    iterator lower_bound(const time_value_type& ts) const { return _search(_storage, ts); }
+
+    /// \brief samples around target_ts next to iter, left == right when no interpolation is needed
+    std::pair<iterator, iterator> neighbours(const iterator& iter, const time_value_type& target_ts) const noexcept
     {
-      return _storage.size() > 2 && target_ts <= (last())->ts && target_ts >= (_storage.begin())->ts;
+      if (iter->ts > target_ts && iter != _storage.begin())
+        return {std::prev(iter), iter};
+      if (iter->ts < target_ts && iter != last())
+        return {iter, std::next(iter)};
+      return {iter, iter};
     }
 
-    template <typename Interpolation = detail::default_interpolation_data<data_value_type, time_value_type>>
-    value_type get_data_inter(const iterator& iter, const time_value_type& target_ts, Interpolation interpolation = {}) const noexcept
+    static std::pair<float, float> weights(const iterator& l, const iterator& r, const time_value_type& ts)
     {
-      auto inter = [&](const iterator& l, const iterator& r, const time_value_type& ts) {
-        const float range = extract(r->ts - l->ts);
-        const float w0    = extract(ts - l->ts) / range;
-        const float w1    = extract(r->ts - ts) / range;
-
-        return interpolation(*l, w0, *r, w1, ts);
-      };
-
-      if (iter->ts > target_ts)
-      {
-        if (iter == _storage.begin())
-          return *iter;
-
-        return inter(std::prev(iter), iter, target_ts);
-      }
-      else if (iter->ts < target_ts)
-      {
-        if (iter == last())
-          return *iter;
-
-        return inter(iter, std::next(iter), target_ts);
-      }
-      else
-        return *iter;
+      const float range = extract(r->ts - l->ts);
+      return {extract(ts - l->ts) / range, extract(r->ts - ts) / range};
     }
 
-  private:
-    iterator last() const { return std::prev(_storage.end()); }
-
     Container& _storage;
+    Search     _search;
   };
   template <typename Container>
   auto access(Container& container)
@@ -165,4 +478,11 @@ namespace daqu
     return storage_data_accessor<Container>(container);
   }
 
+  /// \brief access with a custom search policy, e.g. std::cref(learned_index)
+  template <typename Container, typename Search>
+  auto access(Container& container, Search search)
+  {
+    return storage_data_accessor<Container, Search>(container, search);
+  }
+
 } // namespace daqu
@@ -0,0 +1,142 @@
+#pragma once
+#include "data_queue.h"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <iterator>
+
+namespace daqu
+{
+  /// \brief memoize recent get_data_inter results of one buffer and one interpolation policy
+  ///
+  /// Entries remember the samples they were interpolated from by position counted from the first
+  /// sample ever seen, so evicting the front only drops entries whose samples were evicted.
+  /// Stamps past the back of the buffer are dropped as soon as a newer sample was appended.
+  /// Other changes than appending and front eviction drop all entries.
+  /// Not thread safe, share one cache per consumer thread.
+  template <typename Container, typename Interpolation = detail::default_interpolation_data<typename Container::value_type::data_value_type,
+                                                                                            typename Container::value_type::time_value_type>,
+            std::size_t Size = 16>
+  class interpolation_cache
+  {
+  public:
+    using accessor_type   = storage_data_accessor<Container>;
+    using value_type      = typename accessor_type::value_type;
+    using time_value_type = typename accessor_type::time_value_type;
+
+    interpolation_cache(Container& buff, Interpolation interpolation = {}) : _storage(buff), _interpolation(interpolation){};
+
+    /// \brief interpolated sample at target_ts, default constructed sample if storage is empty
+    value_type get_data_inter(const time_value_type& target_ts)
+    {
+      sync();
+      for (const entry& e : _entries)
+      {
+        if (e.valid && e.ts == target_ts && still_valid(e))
+        {
+          ++_hits;
+          return e.value;
+        }
+      }
+      ++_misses;
+
+      auto       acc = accessor_type(_storage);
+      const auto b   = acc.get_bracket(target_ts);
+      if (b.left == _storage.end())
+        return {};
+
+      entry& e     = _entries[_next];
+      _next        = (_next + 1) % Size;
+      e.valid      = true;
+      e.ts         = target_ts;
+      e.left       = _first + static_cast<std::size_t>(std::distance(_storage.begin(), b.left));
+      e.right      = _first + static_cast<std::size_t>(std::distance(_storage.begin(), b.right));
+      e.left_ts    = b.left->ts;
+      e.right_ts   = b.right->ts;
+      e.past_back  = target_ts > b.right->ts;
+      e.past_front = target_ts < b.left->ts;
+      e.value      = acc.get_data_inter(b, _interpolation);
+      return e.value;
+    }
+
+    void clear() noexcept
+    {
+      for (entry& e : _entries)
+        e.valid = false;
+    }
+
+    std::size_t hits() const noexcept { return _hits; }
+    std::size_t misses() const noexcept { return _misses; }
+
+  private:
+    struct entry
+    {
+      bool            valid = false;
+      time_value_type ts{};
+      std::size_t     left  = 0; // positions count evicted samples
+      std::size_t     right = 0;
+      time_value_type left_ts{};
+      time_value_type right_ts{};
+      bool            past_back  = false; // clamped to last sample
+      bool            past_front = false; // clamped to first sample
+      value_type      value{};
+    };
+
+    /// \brief count samples appended and evicted since last call
+    void sync()
+    {
+      // the last seen sample splits kept from appended samples
+      std::size_t kept = 0;
+      if (_size != _first)
+      {
+        const auto less = [](const value_type& a, const time_value_type& b) { return a.ts < b; };
+        const auto lb   = std::lower_bound(_storage.begin(), _storage.end(), _last_ts, less);
+        const auto ub   = std::find_if(lb, _storage.end(), [this](const value_type& v) { return _last_ts < v.ts; });
+        kept            = std::min(static_cast<std::size_t>(std::distance(_storage.begin(), lb)) + _last_run,
+                                   static_cast<std::size_t>(std::distance(_storage.begin(), ub)));
+
+        const bool consistent = kept > 0 ? kept <= _size - _first && std::next(_storage.begin(), static_cast<std::ptrdiff_t>(kept - 1))->ts == _last_ts
+                                         : _storage.empty() || _last_ts < _storage.begin()->ts;
+        if (!consistent)
+        {
+          clear();
+          _size = _first = kept = 0;
+        }
+        _first    = _size - kept;
+        _last_run = std::min(_last_run, kept);
+      }
+
+      auto it = std::next(_storage.begin(), static_cast<std::ptrdiff_t>(kept));
+      for (; it != _storage.end(); ++_size, ++it)
+      {
+        if (_size == _first || _last_ts < it->ts)
+          _last_run = 1;
+        else
+          ++_last_run;
+        _last_ts = it->ts;
+      }
+    }
+
+    bool still_valid(const entry& e) const
+    {
+      if (e.left < _first || e.right >= _size || (e.past_back && e.right + 1 != _size) || (e.past_front && e.left != _first))
+        return false;
+
+      const auto first = _storage.begin();
+      return std::next(first, static_cast<std::ptrdiff_t>(e.left - _first))->ts == e.left_ts
+             && std::next(first, static_cast<std::ptrdiff_t>(e.right - _first))->ts == e.right_ts;
+    }
+
+    Container&              _storage;
+    Interpolation           _interpolation;
+    std::array<entry, Size> _entries{};
+    std::size_t             _next     = 0;
+    std::size_t             _hits     = 0;
+    std::size_t             _misses   = 0;
+    std::size_t             _first    = 0; // position of the container front, evicted samples are counted
+    std::size_t             _size     = 0; // position past the last seen sample
+    std::size_t             _last_run = 0; // seen samples at the end with stamp _last_ts
+    time_value_type         _last_ts{};
+  };
+
+} // namespace daqu
@@ -0,0 +1,182 @@
+#pragma once
+#include "types.h"
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+namespace daqu
+{
+  // override it if time_since_epoch() not works
+  // Example:
+  // namespace daqu {
+  //   template<>
+  //   std::int64_t index_key(const CustomTime &t) {
+  //      return t.nanoseconds();
+  //   }
+  // }
+  /// \brief return monotone arithmetic key of timestamp
+  template <typename T>
+  auto index_key(const T& ts)
+  {
+    return ts.time_since_epoch().count();
+  }
+
+  /// \brief piecewise-linear model timestamp -> position with bounded error
+  ///
+  /// Every segment predicts the position of the samples it covers with error at most epsilon,
+  /// so a lookup is a model evaluation followed by a binary search over 2 * epsilon + 2 elements.
+  /// Call update() after appending to the container, the open segment is extended in place.
+  /// Use as search policy: daqu::access(buffer, std::cref(index)).
+  template <typename Container>
+  class learned_index
+  {
+  public:
+    static_assert(std::is_same_v<typename Container::value_type::stamped_data_category, daqu::stamped_data_category_tag>,
+                  "works only with daqu::stamped_data type.");
+
+    using iterator        = typename Container::iterator;
+    using value_type      = typename Container::value_type;
+    using time_value_type = typename value_type::time_value_type;
+    using key_type        = decltype(index_key(std::declval<time_value_type>()));
+
+    struct segment
+    {
+      key_type key;       // first key covered by segment
+      double   slope;     // positions per key unit
+      double   intercept; // position of key
+    };
+
+    learned_index(const Container& buff, std::size_t epsilon = 32) : _storage(buff), _epsilon(epsilon) { update(); }
+
+    /// \brief index samples appended since last call and drop samples evicted from the front
+    /// Changes other than appending and front eviction rebuild the index.
+    void update()
+    {
+      const auto less = [](const value_type& a, const key_type& k) { return index_key(a.ts) < k; };
+
+      // the last indexed sample splits kept from appended samples
+      std::size_t kept = 0;
+      if (_size != _first)
+      {
+        const auto lb = std::lower_bound(_storage.begin(), _storage.end(), _last_key, less);
+        const auto ub = std::find_if(lb, _storage.end(), [this](const value_type& v) { return _last_key < index_key(v.ts); });
+        kept          = std::min(static_cast<std::size_t>(std::distance(_storage.begin(), lb)) + _last_run,
+                                 static_cast<std::size_t>(std::distance(_storage.begin(), ub)));
+
+        const bool consistent = kept > 0 ? kept <= _size - _first
+                                               && index_key(std::next(_storage.begin(), static_cast<std::ptrdiff_t>(kept - 1))->ts) == _last_key
+                                         : _storage.empty() || _last_key < index_key(_storage.begin()->ts);
+        if (!consistent)
+        {
+          _segments.clear();
+          _size = _first = kept = 0;
+        }
+        _first = _size - kept;
+        _last_run = std::min(_last_run, kept);
+      }
+
+      // segments left of the front are not needed anymore
+      if (!_storage.empty())
+      {
+        const key_type front = index_key(_storage.begin()->ts);
+        const auto     after = [](const key_type& k, const segment& sg) { return k < sg.key; };
+        const auto     used  = std::upper_bound(_segments.begin(), _segments.end(), front, after);
+        if (used != _segments.begin())
+          _segments.erase(_segments.begin(), std::prev(used));
+      }
+
+      auto it = std::next(_storage.begin(), static_cast<std::ptrdiff_t>(kept));
+      for (; it != _storage.end(); ++_size, ++it)
+      {
+        const key_type key = index_key(it->ts);
+        // duplicates share position of their first occurrence
+        if (_size == _first || key > _last_key)
+        {
+          add_point(key, _size);
+          _last_run = 1;
+        }
+        else
+          ++_last_run;
+        _last_key = key;
+      }
+    }
+
+    /// \brief first element with timestamp equal or greater than ts
+    iterator operator()(Container& storage, const time_value_type& ts) const
+    {
+      const auto less = [](const value_type& a, const time_value_type& b) { return a.ts < b; };
+
+      const key_type key = index_key(ts);
+      if (_segments.empty() || key < _segments.front().key)
+        return std::lower_bound(storage.begin(), storage.end(), ts, less);
+
+      auto seg = std::prev(std::upper_bound(_segments.begin(), _segments.end(), key, [](const key_type& k, const segment& s) { return k < s.key; }));
+
+      // positions count evicted samples, the container may have changed since update
+      const double pred = seg->intercept + seg->slope * static_cast<double>(key - seg->key) - static_cast<double>(_first);
+      const double max  = static_cast<double>(storage.size());
+      const auto   pos  = static_cast<std::size_t>(std::clamp(pred, 0., max));
+
+      const std::size_t lo = std::min(pos > _epsilon + 1 ? pos - _epsilon - 1 : 0, storage.size());
+      const std::size_t hi = std::min(pos + _epsilon + 2, storage.size());
+
+      auto first = std::next(storage.begin(), static_cast<std::ptrdiff_t>(lo));
+      auto last  = std::next(first, static_cast<std::ptrdiff_t>(hi - lo));
+
+      // the bound only holds for indexed keys, fall back to the uncovered part otherwise
+      if (lo > 0 && !less(*std::prev(first), ts))
+        return std::lower_bound(storage.begin(), first, ts, less);
+
+      auto it = std::lower_bound(first, last, ts, less);
+      if (it == last)
+        return std::lower_bound(last, storage.end(), ts, less);
+      return it;
+    }
+
+    std::size_t                 epsilon() const noexcept { return _epsilon; }
+    std::size_t                 size() const noexcept { return _size - _first; }
+    const std::vector<segment>& segments() const noexcept { return _segments; }
+
+  private:
+    void add_point(const key_type& key, std::size_t pos)
+    {
+      const double y   = static_cast<double>(pos);
+      const double eps = static_cast<double>(_epsilon);
+
+      if (!_segments.empty())
+      {
+        segment&     s  = _segments.back();
+        const double dx = static_cast<double>(key - s.key);
+        const double lo = std::max(_slope_lo, (y - eps - s.intercept) / dx);
+        const double hi = std::min(_slope_hi, (y + eps - s.intercept) / dx);
+
+        // point still fits into the cone of feasible slopes of the open segment
+        if (lo <= hi)
+        {
+          _slope_lo = lo;
+          _slope_hi = hi;
+          s.slope   = (lo + hi) / 2;
+          return;
+        }
+      }
+
+      _segments.push_back({key, 0., y});
+      _slope_lo = 0.;
+      _slope_hi = std::numeric_limits<double>::infinity();
+    }
+
+    const Container&     _storage;
+    std::size_t          _epsilon;
+    std::size_t          _first    = 0; // position of the container front, evicted samples are counted
+    std::size_t          _size     = 0; // position past the last indexed sample
+    std::size_t          _last_run = 0; // indexed samples at the end with key _last_key
+    key_type             _last_key{};
+    double               _slope_lo = 0.;
+    double               _slope_hi = std::numeric_limits<double>::infinity();
+    std::vector<segment> _segments;
+  };
+
+} // namespace daqu
@@ -0,0 +1,216 @@
+#pragma once
+#include "data_queue.h"
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+namespace daqu
+{
+  /// \brief contiguous read-only range of one column, invalidated by push_back and pop_front
+  template <typename T>
+  struct column_view
+  {
+    const T* first;
+    const T* last;
+
+    const T*    begin() const noexcept { return first; }
+    const T*    end() const noexcept { return last; }
+    std::size_t size() const noexcept { return static_cast<std::size_t>(last - first); }
+    bool        empty() const noexcept { return first == last; }
+    const T&    front() const noexcept { return *first; }
+    const T&    back() const noexcept { return *(last - 1); }
+    const T&    operator[](std::size_t i) const noexcept { return first[i]; }
+  };
+
+  /// \brief numeric multi-channel samples stored as one column per channel and a shared timestamp column
+  ///
+  /// Evicted samples stay in the columns until more than half of them is evicted, so pop_front
+  /// is amortized O(channels) per sample and columns stay contiguous.
+  template <typename T, typename timeT>
+  class multichannel_buffer
+  {
+  public:
+    static_assert(std::is_arithmetic_v<T>, "works only with numeric channels.");
+
+    using data_value_type = T;
+    using time_value_type = timeT;
+
+    explicit multichannel_buffer(std::size_t channels) : _columns(channels) {}
+
+    /// \brief append sample, values points to channels() values
+    template <typename InputIt>
+    void push_back(const timeT& ts, InputIt values)
+    {
+      _ts.push_back(ts);
+      for (auto& column : _columns)
+        column.push_back(*values++);
+    }
+
+    /// \brief evict the n oldest samples, all if fewer are held
+    void pop_front(std::size_t n = 1)
+    {
+      _first += std::min(n, size());
+      if (_first <= _ts.size() / 2)
+        return;
+
+      const auto evicted = static_cast<std::ptrdiff_t>(_first);
+      _ts.erase(_ts.begin(), std::next(_ts.begin(), evicted));
+      for (auto& column : _columns)
+        column.erase(column.begin(), std::next(column.begin(), evicted));
+      _first = 0;
+    }
+
+    void reserve(std::size_t n)
+    {
+      _ts.reserve(_first + n);
+      for (auto& column : _columns)
+        column.reserve(_first + n);
+    }
+
+    void clear()
+    {
+      _ts.clear();
+      for (auto& column : _columns)
+        column.clear();
+      _first = 0;
+    }
+
+    std::size_t size() const noexcept { return _ts.size() - _first; }
+    bool        empty() const noexcept { return size() == 0; }
+    std::size_t channels() const noexcept { return _columns.size(); }
+
+    column_view<timeT> timestamps() const noexcept { return view(_ts); }
+    column_view<T>     column(std::size_t channel) const noexcept { return view(_columns[channel]); }
+
+  private:
+    template <typename U>
+    column_view<U> view(const std::vector<U>& column) const noexcept
+    {
+      return {column.data() + _first, column.data() + column.size()};
+    }
+
+    std::vector<timeT>          _ts;
+    std::vector<std::vector<T>> _columns;
+    std::size_t                 _first = 0; // evicted samples at the front of the columns
+  };
+
+  template <typename T, typename timeT>
+  class multichannel_accessor
+  {
+  public:
+    using buffer_type                = multichannel_buffer<T, timeT>;
+    using data_value_type            = T;
+    using time_value_type            = timeT;
+    using difference_time_value_type = decltype(std::declval<timeT>() - std::declval<timeT>());
+    using weight_type                = std::conditional_t<std::is_floating_point_v<T>, T, float>;
+
+    /// \brief sample indices around a timestamp, value = left + alpha * (right - left)
+    struct bracket
+    {
+      std::size_t           left; // left == right on exact hit or outside of the buffer, size() if buffer is empty
+      std::size_t           right;
+      weight_type           alpha;
+      storage_access_status status;
+    };
+
+    multichannel_accessor(const buffer_type& buff) : _storage(buff){};
+
+    /// \brief return index of nearest sample, size() if buffer is empty
+    std::size_t get(const time_value_type& ts) const noexcept
+    {
+      const bracket b = get_bracket(ts);
+      if (b.left == b.right)
+        return b.left;
+      // same tie break as storage_data_accessor::get
+      return b.alpha < weight_type(0.5) ? b.left : b.right;
+    }
+
+    bool in_range(const time_value_type& target_ts) const noexcept
+    {
+      const auto ts = _storage.timestamps();
+      return ts.size() > 2 && target_ts <= ts.back() && target_ts >= ts.front();
+    }
+
+    bracket get_bracket(const time_value_type& target_ts) const noexcept
+    {
+      const auto ts = _storage.timestamps();
+      if (ts.empty())
+        return {ts.size(), ts.size(), 0, storage_access_status::not_enough_elements};
+
+      const auto        it = std::lower_bound(ts.begin(), ts.end(), target_ts);
+      const std::size_t r  = static_cast<std::size_t>(std::distance(ts.begin(), it));
+
+      // same status as storage_data_accessor::get_bracket, edge clamps report not_enough_elements
+      if (it == ts.end())
+        return {r - 1, r - 1, 0, storage_access_status::not_enough_elements};
+      if (*it == target_ts)
+        return {r, r, 0, storage_access_status::success};
+      if (it == ts.begin())
+        return {r, r, 0, storage_access_status::not_enough_elements};
+
+      const auto alpha = static_cast<weight_type>(extract(target_ts - ts[r - 1]) / extract(ts[r] - ts[r - 1]));
+      return {r - 1, r, alpha, storage_access_status::success};
+    }
+
+    /// \brief interpolate all channels at target_ts into out, nothing is written for an empty buffer
+    template <typename OutputIt>
+    OutputIt get_data_inter(const time_value_type& target_ts, OutputIt out) const
+    {
+      const bracket b = get_bracket(target_ts);
+      if (b.left == _storage.size())
+        return out;
+
+      for (std::size_t c = 0; c < _storage.channels(); ++c)
+        *out++ = interpolate(_storage.column(c), b);
+      return out;
+    }
+
+    /// \brief interpolate only the listed channels at target_ts into out
+    template <typename ChannelIt, typename OutputIt>
+    OutputIt get_data_inter(const time_value_type& target_ts, ChannelIt first, ChannelIt last, OutputIt out) const
+    {
+      const bracket b = get_bracket(target_ts);
+      if (b.left == _storage.size())
+        return out;
+
+      for (; first != last; ++first)
+        *out++ = interpolate(_storage.column(static_cast<std::size_t>(*first)), b);
+      return out;
+    }
+
+    /// \brief one channel at many brackets, brackets are computed once and reused across channels
+    template <typename BracketIt, typename OutputIt>
+    OutputIt get_column_inter(BracketIt first, BracketIt last, std::size_t channel, OutputIt out) const
+    {
+      const column_view<T> column = _storage.column(channel);
+      for (; first != last; ++first)
+        *out++ = first->left < column.size() ? interpolate(column, *first) : T{};
+      return out;
+    }
+
+  private:
+    static T interpolate(const column_view<T>& column, const bracket& b) noexcept
+    {
+      const weight_type l = static_cast<weight_type>(column[b.left]);
+      const weight_type r = static_cast<weight_type>(column[b.right]);
+      return static_cast<T>(l + b.alpha * (r - l));
+    }
+
+    const buffer_type& _storage;
+  };
+
+  template <typename T, typename timeT>
+  auto access(multichannel_buffer<T, timeT>& buffer)
+  {
+    return multichannel_accessor<T, timeT>(buffer);
+  }
+
+  template <typename T, typename timeT>
+  auto access(const multichannel_buffer<T, timeT>& buffer)
+  {
+    return multichannel_accessor<T, timeT>(buffer);
+  }
+
+} // namespace daqu
@@ -0,0 +1,304 @@
+#pragma once
+#include "data_queue.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <new>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace daqu
+{
+  enum class huge_pages
+  {
+    none = 0,
+    transparent, // 2 MB aligned mapping advised with MADV_HUGEPAGE
+    explicit_2mb // MAP_HUGETLB from the reserved pool, transparent when the pool is empty
+  };
+
+  /// \brief where buffer storage should live
+  struct placement
+  {
+    int        numa_node = -1; // -1 leaves placement to the first touching thread
+    huge_pages pages     = huge_pages::none;
+  };
+
+  /// \brief number of online NUMA nodes, looked up once, 1 when unknown
+  inline int numa_node_count()
+  {
+    static const int count = []() {
+      // format of /sys/devices/system/node/online is "0" or "0-3"
+      std::ifstream online("/sys/devices/system/node/online");
+      std::string   range;
+      if (!(online >> range))
+        return 1;
+
+      const auto dash = range.find_last_of("-,");
+      return dash == std::string::npos ? 1 : std::stoi(range.substr(dash + 1)) + 1;
+    }();
+    return count;
+  }
+
+  /// \brief NUMA node of the calling thread, looked up once per thread, 0 when unknown
+  inline int current_numa_node()
+  {
+#if defined(__linux__) && defined(SYS_getcpu)
+    thread_local const int node = []() {
+      unsigned cpu = 0, n = 0;
+      return syscall(SYS_getcpu, &cpu, &n, nullptr) == 0 ? static_cast<int>(n) : 0;
+    }();
+    return node;
+#else
+    return 0;
+#endif
+  }
+
+  namespace detail
+  {
+    constexpr std::size_t huge_page_size = std::size_t(2) << 20;
+
+    inline std::size_t mapping_size(std::size_t bytes, const placement& p)
+    {
+      return p.pages == huge_pages::none ? bytes : (bytes + huge_page_size - 1) / huge_page_size * huge_page_size;
+    }
+
+#if defined(__linux__)
+    /// \brief allocations below one page, or one huge page, come from the heap and are not placed
+    inline bool heap_allocated(std::size_t bytes, const placement& p)
+    {
+      static const auto page_size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+      return bytes < (p.pages == huge_pages::none ? page_size : huge_page_size);
+    }
+
+    /// \brief anonymous mapping of bytes starting at a multiple of huge_page_size, bytes is a multiple of it
+    inline void* map_huge_aligned(std::size_t bytes)
+    {
+      // over-map by one huge page and trim both ends, so munmap of bytes releases the rest
+      void* mem = mmap(nullptr, bytes + huge_page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (mem == MAP_FAILED)
+        return mem;
+
+      const auto base    = reinterpret_cast<std::uintptr_t>(mem);
+      const auto aligned = (base + huge_page_size - 1) / huge_page_size * huge_page_size;
+      if (aligned != base)
+        munmap(mem, aligned - base);
+      if (aligned - base != huge_page_size)
+        munmap(reinterpret_cast<void*>(aligned + bytes), huge_page_size - (aligned - base));
+      return reinterpret_cast<void*>(aligned);
+    }
+#endif
+
+    /// \brief allocate bytes according to p, fall back to plain pages if binding or huge pages are unsupported
+    inline void* placement_allocate(std::size_t bytes, const placement& p)
+    {
+#if defined(__linux__)
+      if (heap_allocated(bytes, p))
+        return ::operator new(bytes);
+
+      bytes     = mapping_size(bytes, p);
+      void* mem = MAP_FAILED;
+#if defined(MAP_HUGETLB)
+      if (p.pages == huge_pages::explicit_2mb)
+        mem = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+      if (mem == MAP_FAILED)
+      {
+        mem = p.pages == huge_pages::none ? mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0) : map_huge_aligned(bytes);
+        if (mem == MAP_FAILED)
+          throw std::bad_alloc();
+#if defined(MADV_HUGEPAGE)
+        if (p.pages != huge_pages::none)
+          madvise(mem, bytes, MADV_HUGEPAGE);
+#endif
+      }
+
+#if defined(SYS_mbind)
+      if (p.numa_node >= 0 && p.numa_node < std::min(numa_node_count(), 64))
+      {
+        // MPOL_PREFERRED: take pages from the node, others once it is full. Failure keeps default policy.
+        constexpr int       mpol_preferred = 1;
+        const unsigned long mask           = 1UL << p.numa_node;
+        syscall(SYS_mbind, mem, bytes, mpol_preferred, &mask, sizeof(mask) * 8, 0);
+      }
+#endif
+      return mem;
+#else
+      (void)p;
+      return ::operator new(bytes);
+#endif
+    }
+
+    inline void placement_deallocate(void* mem, std::size_t bytes, const placement& p) noexcept
+    {
+#if defined(__linux__)
+      if (heap_allocated(bytes, p))
+        ::operator delete(mem);
+      else
+        munmap(mem, mapping_size(bytes, p));
+#else
+      (void)bytes;
+      (void)p;
+      ::operator delete(mem);
+#endif
+    }
+  } // namespace detail
+
+  /// \brief allocator placing storage on a NUMA node and/or huge pages
+  ///
+  /// Pages are bound with mbind and materialize on the node when first touched, on single node
+  /// machines and other systems it behaves like an allocator of plain pages. Huge page mappings
+  /// are rounded up to 2 MB and aligned to it, use them for large buffers only. Allocations
+  /// smaller than a page, or a huge page, come from the heap and are not placed, so use it with
+  /// contiguous buffers such as std::vector rather than std::deque.
+  /// Example: std::vector<daqu::stamped_data<T, tp>, daqu::placement_allocator<daqu::stamped_data<T, tp>>> buffer(daqu::placement{1});
+  template <typename T>
+  class placement_allocator
+  {
+  public:
+    using value_type = T;
+
+    placement_allocator(const placement& p = {}) noexcept : _placement(p) {}
+
+    template <typename U>
+    placement_allocator(const placement_allocator<U>& other) noexcept : _placement(other.where())
+    {
+    }
+
+    T* allocate(std::size_t n)
+    {
+      if (n > std::numeric_limits<std::size_t>::max() / sizeof(T))
+        throw std::bad_alloc();
+      return static_cast<T*>(detail::placement_allocate(n * sizeof(T), _placement));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept { detail::placement_deallocate(p, n * sizeof(T), _placement); }
+
+    const placement& where() const noexcept { return _placement; }
+
+    template <typename U>
+    bool operator==(const placement_allocator<U>& other) const noexcept
+    {
+      return _placement.numa_node == other.where().numa_node && _placement.pages == other.where().pages;
+    }
+
+    template <typename U>
+    bool operator!=(const placement_allocator<U>& other) const noexcept
+    {
+      return !(*this == other);
+    }
+
+  private:
+    placement _placement;
+  };
+
+  /// \brief per NUMA node copies of the timestamp column used as search policy
+  ///
+  /// Readers search the copy of their own node and touch the samples only for the result.
+  /// Call update() after appending to or evicting from the container, results stay correct
+  /// but fall back to a search of the samples until then.
+  /// Use as search policy: daqu::access(buffer, std::cref(replicas)).
+  template <typename Container>
+  class timestamp_replicas
+  {
+  public:
+    using iterator        = typename Container::iterator;
+    using value_type      = typename Container::value_type;
+    using time_value_type = typename value_type::time_value_type;
+    using column_type     = std::vector<time_value_type, placement_allocator<time_value_type>>;
+
+    timestamp_replicas(const Container& buff, int nodes = numa_node_count()) : _storage(buff)
+    {
+      for (int node = 0; node < std::max(nodes, 1); ++node)
+        _columns.emplace_back(placement_allocator<time_value_type>(placement{node}));
+      update();
+    }
+
+    /// \brief drop stamps evicted from the front and copy stamps appended since last call
+    void update()
+    {
+      const std::size_t size    = _columns.front().size();
+      const std::size_t first   = evicted();
+      const bool        compact = first > size / 2; // amortized O(1) per evicted sample
+      for (auto& column : _columns)
+      {
+        if (first > size)
+          column.clear();
+        else if (compact)
+          column.erase(column.begin(), std::next(column.begin(), static_cast<std::ptrdiff_t>(first)));
+      }
+      _first = compact ? 0 : first;
+
+      for (auto& column : _columns)
+      {
+        auto it = std::next(_storage.begin(), static_cast<std::ptrdiff_t>(column.size() - _first));
+        for (; it != _storage.end(); ++it)
+          column.push_back(it->ts);
+      }
+    }
+
+    /// \brief first element with timestamp equal or greater than ts
+    iterator operator()(Container& storage, const time_value_type& ts) const
+    {
+      const auto less = [](const value_type& a, const time_value_type& b) { return a.ts < b; };
+
+      const column_type& column = replica(current_numa_node());
+      const auto         first  = std::next(column.begin(), static_cast<std::ptrdiff_t>(_first));
+      const auto         pos    = std::min<std::size_t>(static_cast<std::size_t>(std::distance(first, std::lower_bound(first, column.end(), ts))),
+                                                        storage.size());
+      auto               it     = std::next(storage.begin(), static_cast<std::ptrdiff_t>(pos));
+
+      // replica is stale for samples changed after update, check the result against its neighbours
+      if (it != storage.begin() && !less(*std::prev(it), ts))
+        return std::lower_bound(storage.begin(), it, ts, less);
+      if (it != storage.end() && less(*it, ts))
+        return std::lower_bound(std::next(it), storage.end(), ts, less);
+      return it;
+    }
+
+    std::size_t        nodes() const noexcept { return _columns.size(); }
+    const column_type& replica(int node) const noexcept { return _columns[static_cast<std::size_t>(node) % _columns.size()]; }
+
+  private:
+    /// \brief position of the container front in the columns, past the end when they must be rebuilt
+    std::size_t evicted() const
+    {
+      const column_type& column  = _columns.front();
+      const std::size_t  rebuild = column.size() + 1;
+      if (_storage.empty())
+        return rebuild;
+
+      const time_value_type& front = _storage.begin()->ts;
+      const auto             lo    = std::lower_bound(std::next(column.begin(), static_cast<std::ptrdiff_t>(_first)), column.end(), front);
+      if (lo == column.end())
+        return column.size();
+      if (front < *lo)
+        return rebuild;
+
+      // of equal stamps at the front only those still held by the container are kept
+      const auto     hi   = std::upper_bound(lo, column.end(), front);
+      std::ptrdiff_t held = 0;
+      for (auto it = _storage.begin(); it != _storage.end() && held < std::distance(lo, hi) && it->ts == front; ++it)
+        ++held;
+
+      const auto first = std::prev(hi, held);
+      const auto kept  = std::distance(first, column.end());
+      if (static_cast<std::size_t>(kept) > _storage.size() || std::next(_storage.begin(), kept - 1)->ts != column.back())
+        return rebuild;
+      return static_cast<std::size_t>(std::distance(column.begin(), first));
+    }
+
+    const Container&         _storage;
+    std::vector<column_type> _columns;
+    std::size_t              _first = 0; // position of the container front in the columns
+  };
+
+} // namespace daqu
@@ -0,0 +1,218 @@
+#pragma once
+#include "data_queue.h"
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+namespace daqu
+{
+  /// \brief min/max/mean summary of consecutive samples
+  template <typename timeT>
+  struct bucket
+  {
+    timeT       first_ts;
+    timeT       last_ts;
+    float       min;
+    float       max;
+    double      sum;
+    std::size_t count;
+
+    float mean() const noexcept { return static_cast<float>(sum / static_cast<double>(count)); }
+  };
+
+  /// \brief multi-resolution summary of a buffer for long-horizon queries
+  ///
+  /// Level 0 is the buffer itself, bucket of level l covers factor^l samples. Payloads are
+  /// reduced to float with extract(). Call update() after appending to or evicting from the
+  /// front of the buffer, rebuild() after any other change.
+  template <typename Container>
+  class pyramid
+  {
+  public:
+    static_assert(std::is_same_v<typename Container::value_type::stamped_data_category, daqu::stamped_data_category_tag>,
+                  "works only with daqu::stamped_data type.");
+
+    using value_type                 = typename Container::value_type;
+    using time_value_type            = typename value_type::time_value_type;
+    using difference_time_value_type = decltype(std::declval<time_value_type>() - std::declval<time_value_type>());
+    using bucket_type                = bucket<time_value_type>;
+
+    pyramid(const Container& buff, std::size_t levels = 4, std::size_t factor = 10) : _storage(buff), _factor(factor), _levels(levels)
+    {
+      std::size_t samples = 1;
+      for (auto& level : _levels)
+        level.samples = samples *= _factor;
+      update();
+    }
+
+    /// \brief drop samples evicted from the front and summarize samples appended since last call
+    /// Costs O(levels * factor) besides the appended samples.
+    void update()
+    {
+      // the last summarized sample splits kept from appended samples
+      std::size_t kept = 0;
+      if (_end != _begin)
+      {
+        const auto less = [](const value_type& a, const time_value_type& b) { return a.ts < b; };
+        const auto lb   = std::lower_bound(_storage.begin(), _storage.end(), _last_ts, less);
+        const auto ub   = std::find_if(lb, _storage.end(), [this](const value_type& v) { return _last_ts < v.ts; });
+        kept            = std::min(static_cast<std::size_t>(std::distance(_storage.begin(), lb)) + _last_run,
+                                   static_cast<std::size_t>(std::distance(_storage.begin(), ub)));
+
+        const bool consistent = kept > 0 ? kept <= _end - _begin && std::next(_storage.begin(), static_cast<std::ptrdiff_t>(kept - 1))->ts == _last_ts
+                                         : _storage.empty() || _last_ts < _storage.begin()->ts;
+        if (!consistent)
+          return rebuild();
+
+        _last_run = std::min(_last_run, kept);
+        evict(_end - _begin - kept);
+      }
+
+      auto it = std::next(_storage.begin(), static_cast<std::ptrdiff_t>(kept));
+      for (; it != _storage.end(); ++it, ++_end)
+      {
+        const float v = extract(it->data);
+        for (auto& level : _levels)
+        {
+          if (level.buckets.empty() || _end == (level.first + level.buckets.size()) * level.samples)
+          {
+            if (level.buckets.empty())
+              level.first = _end / level.samples;
+            level.buckets.push_back({it->ts, it->ts, v, v, 0., 0});
+          }
+          add(level.buckets.back(), {it->ts, it->ts, v, v, static_cast<double>(v), 1});
+        }
+
+        _last_run = _end != _begin && it->ts == _last_ts ? _last_run + 1 : 1;
+        _last_ts  = it->ts;
+      }
+    }
+
+    void rebuild()
+    {
+      for (auto& level : _levels)
+        level.buckets.clear();
+      _begin = _end = _last_run = 0;
+      update();
+    }
+
+    /// \brief number of levels above the raw buffer
+    std::size_t levels() const noexcept { return _levels.size(); }
+
+    /// \brief buckets of level 1..levels()
+    const std::deque<bucket_type>& level(std::size_t l) const noexcept { return _levels[l - 1].buckets; }
+
+    /// \brief write buckets covering [from, to] from the coarsest level with bucket duration not above resolution
+    /// \return used level, 0 means the raw samples were written as single sample buckets
+    template <typename OutputIt>
+    std::size_t query(const time_value_type& from, const time_value_type& to, const difference_time_value_type& resolution, OutputIt out) const
+    {
+      if (_storage.empty() || to < from)
+        return 0;
+
+      std::size_t l = 0;
+      if (_storage.size() > 1)
+      {
+        const auto interval = (std::prev(_storage.end())->ts - _storage.begin()->ts) / static_cast<std::ptrdiff_t>(_storage.size() - 1);
+        while (l < _levels.size() && interval * static_cast<std::ptrdiff_t>(_levels[l].samples) <= resolution)
+          ++l;
+      }
+
+      if (l == 0)
+      {
+        const auto less  = [](const value_type& a, const time_value_type& b) { return a.ts < b; };
+        auto       first = std::lower_bound(_storage.begin(), _storage.end(), from, less);
+        for (; first != _storage.end() && !(to < first->ts); ++first)
+        {
+          const float v = extract(first->data);
+          *out++        = bucket_type{first->ts, first->ts, v, v, static_cast<double>(v), 1};
+        }
+        return 0;
+      }
+
+      const auto& buckets = _levels[l - 1].buckets;
+      const auto  less    = [](const bucket_type& b, const time_value_type& ts) { return b.last_ts < ts; };
+      auto        first   = std::lower_bound(buckets.begin(), buckets.end(), from, less);
+      for (; first != buckets.end() && !(to < first->first_ts); ++first)
+        *out++ = *first;
+      return l;
+    }
+
+  private:
+    struct level_data
+    {
+      std::size_t             samples = 0; // samples per bucket
+      std::size_t             first   = 0; // bucket index of buckets.front(), bucket i covers samples [i * samples, (i + 1) * samples)
+      std::deque<bucket_type> buckets;
+    };
+
+    static void add(bucket_type& into, const bucket_type& b)
+    {
+      if (into.count == 0)
+        into.first_ts = b.first_ts;
+      into.last_ts = b.last_ts;
+      into.min     = std::min(into.min, b.min);
+      into.max     = std::max(into.max, b.max);
+      into.sum += b.sum;
+      into.count += b.count;
+    }
+
+    /// \brief drop the first n samples, buckets partly evicted are summarized again from the level below
+    void evict(std::size_t n)
+    {
+      if (n == 0)
+        return;
+      _begin += n;
+
+      const level_data* below = nullptr;
+      for (auto& level : _levels)
+      {
+        while (!level.buckets.empty() && (level.first + 1) * level.samples <= _begin)
+        {
+          level.buckets.pop_front();
+          ++level.first;
+        }
+
+        if (!level.buckets.empty() && level.first * level.samples < _begin)
+        {
+          const std::size_t last = std::min((level.first + 1) * level.samples, _end);
+          bucket_type&      b    = level.buckets.front();
+          b.count                = 0;
+          b.sum                  = 0.;
+          b.min                  = std::numeric_limits<float>::max();
+          b.max                  = std::numeric_limits<float>::lowest();
+          if (below == nullptr)
+          {
+            auto it = _storage.begin();
+            for (std::size_t i = _begin; i < last; ++i, ++it)
+            {
+              const float v = extract(it->data);
+              add(b, {it->ts, it->ts, v, v, static_cast<double>(v), 1});
+            }
+          }
+          else
+          {
+            for (std::size_t i = 0; i < below->buckets.size() && (below->first + i) * below->samples < last; ++i)
+              add(b, below->buckets[i]);
+          }
+          if (b.count == 0)
+            level.buckets.pop_front();
+        }
+        below = &level;
+      }
+    }
+
+    const Container&        _storage;
+    std::size_t             _factor;
+    std::size_t             _begin    = 0; // index of the first sample in the container, counted since rebuild
+    std::size_t             _end      = 0; // index past the last summarized sample
+    std::size_t             _last_run = 0; // summarized samples at the end stamped with _last_ts
+    time_value_type         _last_ts{};
+    std::vector<level_data> _levels;
+  };
+
+} // namespace daqu
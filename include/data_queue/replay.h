@@ -0,0 +1,172 @@
+#pragma once
+#include "checkpoint.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace daqu
+{
+  enum class replay_mode
+  {
+    real_time = 0,      // recorded pace
+    scaled,             // recorded pace times speed
+    as_fast_as_possible // no waiting, order only
+  };
+
+  /// \brief publish recorded buffers into live buffers in timestamp order along a virtual clock
+  ///
+  /// Samples of all streams are merged by timestamp, equal timestamps keep the order in which
+  /// the streams were added, so every run publishes the same sequence. Live buffers need
+  /// push_back and are filled from the thread calling run().
+  template <typename timeT, typename Clock = std::chrono::steady_clock>
+  class replayer
+  {
+  public:
+    /// \brief throws std::invalid_argument if speed is not positive
+    explicit replayer(replay_mode mode = replay_mode::as_fast_as_possible, double speed = 1.)
+        : _mode(mode), _speed(mode == replay_mode::real_time ? 1. : speed)
+    {
+      if (!(speed > 0.))
+        throw std::invalid_argument("replay speed must be positive");
+    }
+
+    /// \brief replay recorded, which must outlive run(), into live
+    template <typename Recorded, typename Live>
+    void add_stream(const Recorded& recorded, Live& live)
+    {
+      _streams.push_back(std::make_unique<stream<Recorded, Live>>(recorded, live));
+    }
+
+    /// \brief replay checkpoint file written by save_checkpoint into live
+    /// Recorded is the buffer type the file is loaded into: replay.add_stream<std::vector<sample>>(path, live).
+    template <typename Recorded, typename Live>
+    checkpoint_status add_stream(const std::string& path, Live& live)
+    {
+      auto owned = std::make_unique<owning_stream<Recorded, Live>>(live);
+      auto res   = load_checkpoint(owned->recorded, path);
+      if (res == checkpoint_status::success)
+        _streams.push_back(std::move(owned));
+      return res;
+    }
+
+    /// \brief publish every sample, returns number of published samples
+    std::size_t run()
+    {
+      const std::size_t published = publish_all();
+      // a stop() issued before run() ends this run only
+      _stop = false;
+      return published;
+    }
+
+    /// \brief make a running or the next run() return, may be called from another thread
+    void stop() noexcept { _stop = true; }
+
+  private:
+    std::size_t publish_all()
+    {
+      using entry = std::pair<timeT, std::size_t>;
+      std::priority_queue<entry, std::vector<entry>, std::greater<>> next;
+      for (std::size_t i = 0; i < _streams.size(); ++i)
+      {
+        _streams[i]->rewind();
+        if (!_streams[i]->done())
+          next.emplace(_streams[i]->ts(), i);
+      }
+      if (next.empty())
+        return 0;
+
+      const timeT virtual_start = next.top().first;
+      const auto  wall_start    = Clock::now();
+
+      std::size_t published = 0;
+      while (!next.empty() && !_stop.load(std::memory_order_relaxed))
+      {
+        const std::size_t i = next.top().second;
+        next.pop();
+
+        stream_base& s = *_streams[i];
+        wait_until(wall_start, s.ts() - virtual_start);
+        s.publish();
+        ++published;
+
+        // keep publishing this stream while it stays ahead of all others
+        while (!s.done() && (next.empty() || entry(s.ts(), i) < next.top()))
+        {
+          wait_until(wall_start, s.ts() - virtual_start);
+          s.publish();
+          ++published;
+        }
+
+        if (!s.done())
+          next.emplace(s.ts(), i);
+      }
+      return published;
+    }
+
+    struct stream_base
+    {
+      virtual ~stream_base() = default;
+
+      virtual void         rewind()  = 0;
+      virtual bool         done()    = 0;
+      virtual const timeT& ts()      = 0;
+      virtual void         publish() = 0;
+    };
+
+    template <typename Recorded, typename Live>
+    struct stream : stream_base
+    {
+      stream(const Recorded& r, Live& l) : recorded(r), live(l), it(r.begin()) {}
+
+      void         rewind() override { it = recorded.begin(); }
+      bool         done() override { return it == recorded.end(); }
+      const timeT& ts() override { return it->ts; }
+      void         publish() override { live.push_back(*it++); }
+
+      const Recorded&                   recorded;
+      Live&                             live;
+      typename Recorded::const_iterator it;
+    };
+
+    template <typename Recorded, typename Live>
+    struct owning_stream : stream_base
+    {
+      explicit owning_stream(Live& l) : live(l), it(recorded.cbegin()) {}
+
+      void         rewind() override { it = recorded.cbegin(); }
+      bool         done() override { return it == recorded.cend(); }
+      const timeT& ts() override { return it->ts; }
+      void         publish() override { live.push_back(*it++); }
+
+      Recorded                          recorded;
+      Live&                             live;
+      typename Recorded::const_iterator it;
+    };
+
+    template <typename Duration>
+    void wait_until(const typename Clock::time_point& wall_start, const Duration& virtual_elapsed) const
+    {
+      if (_mode == replay_mode::as_fast_as_possible)
+        return;
+
+      const std::chrono::duration<double, typename Duration::period> scaled(static_cast<double>(virtual_elapsed.count()) / _speed);
+      const auto due = wall_start + std::chrono::duration_cast<typename Clock::duration>(scaled);
+      if (Clock::now() < due)
+        std::this_thread::sleep_until(due);
+    }
+
+    replay_mode                               _mode;
+    double                                    _speed;
+    std::atomic<bool>                         _stop{false};
+    std::vector<std::unique_ptr<stream_base>> _streams;
+  };
+
+} // namespace daqu
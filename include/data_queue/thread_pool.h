@@ -0,0 +1,154 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace daqu
+{
+  /// \brief fixed size pool with one task queue per worker
+  ///
+  /// Workers run their own queue newest first and steal the oldest task of other
+  /// workers when it is empty. Tasks submitted from a worker go to its own queue.
+  class thread_pool
+  {
+  public:
+    using task = std::function<void()>;
+
+    explicit thread_pool(std::size_t threads = std::thread::hardware_concurrency())
+    {
+      threads = threads == 0 ? 1 : threads;
+      for (std::size_t i = 0; i < threads; ++i)
+        _queues.push_back(std::make_unique<worker_queue>());
+      for (std::size_t i = 0; i < threads; ++i)
+        _threads.emplace_back([this, i]() { run(i); });
+    }
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    /// \brief finish queued tasks and join workers
+    ~thread_pool()
+    {
+      wait();
+      {
+        std::lock_guard<std::mutex> lock(_m);
+        _stop = true;
+      }
+      _wake.notify_all();
+      for (auto& t : _threads)
+        t.join();
+    }
+
+    void submit(task t)
+    {
+      const std::size_t q = _current.pool == this ? _current.index : _next++ % _queues.size();
+      {
+        // count before publishing, a worker may pop and finish the task right after the push
+        std::lock_guard<std::mutex> lock(_m);
+        ++_queued;
+        ++_pending;
+      }
+      {
+        std::lock_guard<std::mutex> lock(_queues[q]->m);
+        _queues[q]->tasks.push_back(std::move(t));
+      }
+      _wake.notify_one();
+    }
+
+    /// \brief block until every submitted task finished, tasks may submit new tasks meanwhile
+    void wait()
+    {
+      std::unique_lock<std::mutex> lock(_m);
+      _idle.wait(lock, [this]() { return _pending == 0; });
+    }
+
+    std::size_t size() const noexcept { return _threads.size(); }
+
+  private:
+    struct worker_queue
+    {
+      std::mutex       m;
+      std::deque<task> tasks;
+    };
+
+    struct worker_id
+    {
+      const thread_pool* pool;
+      std::size_t        index;
+    };
+
+    bool pop(std::size_t self, task& t)
+    {
+      {
+        std::lock_guard<std::mutex> lock(_queues[self]->m);
+        if (!_queues[self]->tasks.empty())
+        {
+          t = std::move(_queues[self]->tasks.back());
+          _queues[self]->tasks.pop_back();
+          return true;
+        }
+      }
+
+      for (std::size_t i = 1; i < _queues.size(); ++i)
+      {
+        worker_queue&               victim = *_queues[(self + i) % _queues.size()];
+        std::lock_guard<std::mutex> lock(victim.m);
+        if (!victim.tasks.empty())
+        {
+          t = std::move(victim.tasks.front());
+          victim.tasks.pop_front();
+          return true;
+        }
+      }
+      return false;
+    }
+
+    void run(std::size_t self)
+    {
+      _current = {this, self};
+
+      for (;;)
+      {
+        task t;
+        if (pop(self, t))
+        {
+          {
+            std::lock_guard<std::mutex> lock(_m);
+            --_queued;
+          }
+          t();
+
+          std::lock_guard<std::mutex> lock(_m);
+          if (--_pending == 0)
+            _idle.notify_all();
+          continue;
+        }
+
+        std::unique_lock<std::mutex> lock(_m);
+        _wake.wait(lock, [this]() { return _stop || _queued > 0; });
+        if (_stop && _queued == 0)
+          return;
+      }
+    }
+
+    inline static thread_local worker_id _current{};
+
+    std::vector<std::unique_ptr<worker_queue>> _queues;
+    std::vector<std::thread>                   _threads;
+    std::atomic<std::size_t>                   _next{0};
+
+    std::mutex              _m;
+    std::condition_variable _wake;
+    std::condition_variable _idle;
+    std::size_t             _queued  = 0; // tasks waiting in queues
+    std::size_t             _pending = 0; // tasks submitted and not finished
+    bool                    _stop    = false;
+  };
+
+} // namespace daqu
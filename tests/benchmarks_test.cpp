@@ -1,13 +1,24 @@
 #include <benchmark/benchmark.h>
 
+#include <data_queue/checkpoint.h>
 #include <data_queue/data_queue.h>
+#include <data_queue/learned_index.h>
+#include <data_queue/multichannel.h>
+#include <data_queue/placement.h>
+#include <data_queue/replay.h>
 
 #include <algorithm>
+#include <array>
 #include <chrono>
+#include <functional>
 #include <iterator>
 #include <numeric>
+#include <random>
+#include <string>
 #include <vector>
 
+#include <cstdint>
+#include <cstdio>
 #include <ctime>
 
 /*
@@ -529,5 +540,464 @@ BENCHMARK(BM_creation_accessor_get_data_inter_with_interpolation_in_middle)->Arg
 BENCHMARK(BM_creation_accessor_get_data_inter_with_interpolation_random_access)->Arg(8)->Arg(64)->Arg(512)->Arg(1 << 10)->Arg(8 << 10);
 BENCHMARK(BM_creation_accessor_get_data_inter_with_interpolation_at_end)->Arg(8)->Arg(64)->Arg(512)->Arg(1 << 10)->Arg(8 << 10);
 
+/*
+ *
+ * Buffers of the benchmarks below
+ *
+ */
+namespace
+{
+  using jittered_tp = std::chrono::time_point<std::chrono::steady_clock, std::chrono::microseconds>;
+
+  /// \brief call f(i, ts) for n increasing timestamps 10 us apart with 1 us jitter, as produced by a real sensor
+  template <typename F>
+  void for_each_jittered(int64_t n, F f)
+  {
+    std::mt19937                           gen(42);
+    std::uniform_int_distribution<int64_t> jitter(9, 11);
+    int64_t                                t = 0;
+    for (int i = 0; i < n; ++i)
+      f(i, jittered_tp{std::chrono::microseconds(t += jitter(gen))});
+  }
+
+  /// \brief buffer of n samples with data 0, 1, ... at jittered timestamps
+  template <typename Buffer>
+  void fill_jittered(Buffer& buffer, int64_t n)
+  {
+    buffer.reserve(static_cast<std::size_t>(n));
+    for_each_jittered(n, [&](int i, const jittered_tp& ts) { buffer.emplace_back(i, ts); });
+  }
+
+  /// \brief fixed pseudo random timestamp between 0 and last
+  jittered_tp random_timestamp(const jittered_tp& last)
+  {
+    std::mt19937                           gen(42);
+    std::uniform_int_distribution<int64_t> ts(0, last.time_since_epoch().count());
+    return jittered_tp{std::chrono::microseconds(ts(gen))};
+  }
+} // namespace
+
+/*
+ *
+ * Benchmark bracket get_bracket(const time_value_type& ts, std::size_t k = 1) const noexcept
+ *
+ */
+namespace
+{
+  void BM_creation_accessor_get_bracket_random_access(benchmark::State& state)
+  {
+    // Perform setup here
+    using buffT = std::vector<daqu::stamped_data<int, jittered_tp>>;
+    buffT buffer;
+    fill_jittered(buffer, state.range(0));
+    const auto ts = random_timestamp(buffer.back().ts);
+
+    for (auto _ : state)
+    {
+      benchmark::DoNotOptimize(daqu::access(buffer).get_bracket(ts, 2));
+    }
+  }
+
+  void BM_creation_accessor_get_data_inter_with_bracket_random_access(benchmark::State& state)
+  {
+    // Perform setup here
+    using buffT = std::vector<daqu::stamped_data<int, jittered_tp>>;
+    buffT buffer;
+    fill_jittered(buffer, state.range(0));
+    const auto ts = random_timestamp(buffer.back().ts);
+
+    for (auto _ : state)
+    {
+      auto b = daqu::access(buffer).get_bracket(ts);
+      benchmark::DoNotOptimize(daqu::access(buffer).get_data_inter(b, int_interpolation()));
+    }
+  }
+} // namespace
+
+BENCHMARK(BM_creation_accessor_get_bracket_random_access)->Arg(8)->Arg(64)->Arg(512)->Arg(1 << 10)->Arg(8 << 10);
+BENCHMARK(BM_creation_accessor_get_data_inter_with_bracket_random_access)->Arg(8)->Arg(64)->Arg(512)->Arg(1 << 10)->Arg(8 << 10);
+
+/*
+ *
+ * Benchmark search policies: std::lower_bound vs learned_index vs prefetch_search, on plain and huge pages
+ * Buffers up to 1G elements (16 GB) are benchmarked when built with DATA_QUEUE_LARGE_BENCHMARKS.
+ *
+ */
+namespace
+{
+  template <typename MakeSearch>
+  void search_policy_random_queries(benchmark::State& state, MakeSearch make_search, const daqu::placement& where = {})
+  {
+    // Perform setup here
+    using value_type = daqu::stamped_data<int, jittered_tp>;
+    using buffT      = std::vector<value_type, daqu::placement_allocator<value_type>>;
+    buffT buffer{daqu::placement_allocator<value_type>(where)};
+    fill_jittered(buffer, state.range(0));
+
+    std::mt19937                           gen(42);
+    std::uniform_int_distribution<int64_t> query(0, buffer.back().ts.time_since_epoch().count());
+    std::vector<jittered_tp>               queries(1 << 12);
+    std::generate(queries.begin(), queries.end(), [&]() { return jittered_tp{std::chrono::microseconds(query(gen))}; });
+
+    auto        search = make_search(buffer);
+    std::size_t i      = 0;
+    for (auto _ : state)
+    {
+      benchmark::DoNotOptimize(daqu::access(buffer, std::cref(search)).get(queries[i++ & (queries.size() - 1)]));
+    }
+  }
+
+  void search_sizes(benchmark::internal::Benchmark* b)
+  {
+    b->Arg(1 << 10)->Arg(1 << 16)->Arg(1 << 20)->Arg(1 << 24);
+#ifdef DATA_QUEUE_LARGE_BENCHMARKS
+    b->Arg(1 << 27)->Arg(1 << 30);
+#endif
+  }
+
+  void BM_lower_bound_search_random_queries(benchmark::State& state)
+  {
+    search_policy_random_queries(state, [](const auto&) { return daqu::lower_bound_search(); });
+  }
+
+  void BM_learned_index_search_random_queries(benchmark::State& state)
+  {
+    search_policy_random_queries(state, [](const auto& buffer) { return daqu::learned_index<std::decay_t<decltype(buffer)>>(buffer); });
+  }
+
+  void BM_prefetch_search_random_queries(benchmark::State& state)
+  {
+    search_policy_random_queries(state, [](const auto&) { return daqu::prefetch_search(); });
+  }
+
+  void BM_lower_bound_search_huge_pages_random_queries(benchmark::State& state)
+  {
+    search_policy_random_queries(
+        state, [](const auto&) { return daqu::lower_bound_search(); }, daqu::placement{-1, daqu::huge_pages::transparent});
+  }
+
+  void BM_prefetch_search_huge_pages_random_queries(benchmark::State& state)
+  {
+    search_policy_random_queries(
+        state, [](const auto&) { return daqu::prefetch_search(); }, daqu::placement{-1, daqu::huge_pages::transparent});
+  }
+} // namespace
+
+BENCHMARK(BM_lower_bound_search_random_queries)->Apply(search_sizes);
+BENCHMARK(BM_learned_index_search_random_queries)->Apply(search_sizes);
+BENCHMARK(BM_prefetch_search_random_queries)->Apply(search_sizes);
+BENCHMARK(BM_lower_bound_search_huge_pages_random_queries)->Apply(search_sizes);
+BENCHMARK(BM_prefetch_search_huge_pages_random_queries)->Apply(search_sizes);
+
+/*
+ *
+ * Benchmark checkpoint_status load_checkpoint(Container& buff, const std::string& path)
+ *
+ */
+namespace
+{
+  void BM_load_checkpoint(benchmark::State& state)
+  {
+    // Perform setup here
+    using buffT = std::vector<daqu::stamped_data<int, jittered_tp>>;
+    buffT buffer;
+    fill_jittered(buffer, state.range(0));
+
+    const std::string path = "data_queue_benchmark_checkpoint.bin";
+    daqu::save_checkpoint(buffer, path);
+
+    buffT restored;
+    for (auto _ : state)
+    {
+      benchmark::DoNotOptimize(daqu::load_checkpoint(restored, path));
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0) * static_cast<int64_t>(sizeof(buffT::value_type)));
+    std::remove(path.c_str());
+  }
+} // namespace
+
+BENCHMARK(BM_load_checkpoint)->Arg(1 << 10)->Arg(1 << 20)->Arg(16 << 20);
+
+/*
+ *
+ * Worst case latency of search followed by interpolation, reported as max_ns and p99_ns counters
+ *
+ */
+namespace
+{
+  template <typename Query>
+  void query_latency_random_queries(benchmark::State& state, Query query)
+  {
+    // Perform setup here
+    using buffT = std::vector<daqu::stamped_data<int, jittered_tp>>;
+    buffT buffer;
+    fill_jittered(buffer, state.range(0));
+
+    std::mt19937                           gen(42);
+    std::uniform_int_distribution<int64_t> ts(0, buffer.back().ts.time_since_epoch().count());
+    std::vector<jittered_tp>               queries(1 << 12);
+    std::generate(queries.begin(), queries.end(), [&]() { return jittered_tp{std::chrono::microseconds(ts(gen))}; });
+
+    std::vector<double> latency;
+    latency.reserve(1 << 20);
+    std::size_t i = 0;
+    for (auto _ : state)
+    {
+      const auto start = std::chrono::steady_clock::now();
+      benchmark::DoNotOptimize(query(buffer, queries[i++ & (queries.size() - 1)]));
+      const auto stop = std::chrono::steady_clock::now();
+      if (latency.size() < latency.capacity())
+        latency.push_back(std::chrono::duration<double, std::nano>(stop - start).count());
+    }
+
+    std::sort(latency.begin(), latency.end());
+    state.counters["max_ns"] = latency.back();
+    state.counters["p99_ns"] = latency[latency.size() * 99 / 100];
+  }
+
+  void BM_get_data_inter_latency(benchmark::State& state)
+  {
+    query_latency_random_queries(state, [](auto& buffer, const auto& ts) {
+      return daqu::access(buffer).get_data_inter(daqu::access(buffer).get(ts), ts, int_interpolation());
+    });
+  }
+
+  void BM_get_data_inter_with_deadline_latency(benchmark::State& state)
+  {
+    query_latency_random_queries(state, [](auto& buffer, const auto& ts) {
+      const daqu::deadline<> dl{std::chrono::steady_clock::now() + std::chrono::microseconds(1)};
+      return daqu::access(buffer).get_data_inter(ts, dl, int_interpolation()).value;
+    });
+  }
+} // namespace
+
+BENCHMARK(BM_get_data_inter_latency)->Arg(1 << 10)->Arg(1 << 16)->Arg(1 << 20);
+BENCHMARK(BM_get_data_inter_with_deadline_latency)->Arg(1 << 10)->Arg(1 << 16)->Arg(1 << 20);
+
+/*
+ *
+ * Benchmark 64 channel interpolation: array payload vs columnar multichannel_buffer
+ *
+ */
+namespace
+{
+  constexpr std::size_t channels = 64;
+
+  void BM_array_payload_get_data_inter_random_access(benchmark::State& state)
+  {
+    // Perform setup here
+    using sample = daqu::stamped_data<std::array<float, channels>, jittered_tp>;
+    using buffT  = std::vector<sample>;
+    buffT buffer;
+    buffer.reserve(static_cast<std::size_t>(state.range(0)));
+    for_each_jittered(state.range(0), [&](int i, const jittered_tp& ts) {
+      std::array<float, channels> values;
+      values.fill(static_cast<float>(i));
+      buffer.emplace_back(values, ts);
+    });
+
+    auto inter = [](const sample& l, const float w0, const sample& r, const float, const jittered_tp& ts) {
+      sample res(l.data, ts);
+      for (std::size_t c = 0; c < channels; ++c)
+        res.data[c] = l.data[c] + w0 * (r.data[c] - l.data[c]);
+      return res;
+    };
+
+    const auto ts = random_timestamp(buffer.back().ts);
+
+    for (auto _ : state)
+    {
+      benchmark::DoNotOptimize(daqu::access(buffer).get_data_inter(daqu::access(buffer).get_bracket(ts), inter));
+    }
+  }
+
+  void BM_multichannel_get_data_inter_random_access(benchmark::State& state)
+  {
+    // Perform setup here
+    daqu::multichannel_buffer<float, jittered_tp> buffer(channels);
+    buffer.reserve(static_cast<std::size_t>(state.range(0)));
+    for_each_jittered(state.range(0), [&](int i, const jittered_tp& ts) {
+      std::array<float, channels> values;
+      values.fill(static_cast<float>(i));
+      buffer.push_back(ts, values.begin());
+    });
+
+    const auto ts = random_timestamp(buffer.timestamps().back());
+
+    std::array<float, channels> out;
+    for (auto _ : state)
+    {
+      benchmark::DoNotOptimize(daqu::access(buffer).get_data_inter(ts, out.begin()));
+    }
+  }
+} // namespace
+
+BENCHMARK(BM_array_payload_get_data_inter_random_access)->Arg(1 << 10)->Arg(1 << 16);
+BENCHMARK(BM_multichannel_get_data_inter_random_access)->Arg(1 << 10)->Arg(1 << 16);
+
+/*
+ *
+ * Benchmark classification of 1024 sorted candidate timestamps: one call per timestamp vs bulk call
+ *
+ */
+namespace
+{
+  template <typename Classify>
+  void classify_sorted_candidates(benchmark::State& state, Classify classify)
+  {
+    // Perform setup here
+    using buffT = std::vector<daqu::stamped_data<int, jittered_tp>>;
+    buffT buffer;
+    fill_jittered(buffer, state.range(0));
+
+    std::mt19937                           gen(42);
+    std::uniform_int_distribution<int64_t> ts(-100, buffer.back().ts.time_since_epoch().count() + 100);
+    std::vector<jittered_tp>               queries(1 << 10);
+    std::generate(queries.begin(), queries.end(), [&]() { return jittered_tp{std::chrono::microseconds(ts(gen))}; });
+    std::sort(queries.begin(), queries.end());
+
+    std::vector<daqu::storage_data_accessor<buffT>::result> res(queries.size());
+    std::vector<std::uint64_t>                              mask(queries.size() / 64);
+    for (auto _ : state)
+    {
+      classify(buffer, queries, res, mask);
+      benchmark::DoNotOptimize(res.data());
+      benchmark::DoNotOptimize(mask.data());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(queries.size()));
+  }
+
+  void BM_classify_one_by_one(benchmark::State& state)
+  {
+    classify_sorted_candidates(state, [](auto& buffer, const auto& queries, auto& res, auto& mask) {
+      std::fill(mask.begin(), mask.end(), 0);
+      for (std::size_t i = 0; i < queries.size(); ++i)
+      {
+        mask[i / 64] |= std::uint64_t(daqu::access(buffer).in_range(queries[i])) << (i % 64);
+        res[i] = daqu::access(buffer).get(queries[i], std::chrono::microseconds(3));
+      }
+    });
+  }
+
+  void BM_classify_bulk(benchmark::State& state)
+  {
+    classify_sorted_candidates(state, [](auto& buffer, const auto& queries, auto& res, auto& mask) {
+      daqu::access(buffer).in_range(queries.begin(), queries.end(), mask.begin());
+      daqu::access(buffer).get(queries.begin(), queries.end(), std::chrono::microseconds(3), res.begin());
+    });
+  }
+} // namespace
+
+BENCHMARK(BM_classify_one_by_one)->Arg(1 << 10)->Arg(1 << 16)->Arg(1 << 20);
+BENCHMARK(BM_classify_bulk)->Arg(1 << 10)->Arg(1 << 16)->Arg(1 << 20);
+
+/*
+ *
+ * Benchmark local vs remote NUMA placement, argument is (buffer size, node of the buffer)
+ * On single node machines both nodes are the same.
+ *
+ */
+namespace
+{
+  void BM_placement_get_random_queries(benchmark::State& state)
+  {
+    // Perform setup here
+    using value_type = daqu::stamped_data<int, jittered_tp>;
+    using buffT      = std::vector<value_type, daqu::placement_allocator<value_type>>;
+
+    const int node = static_cast<int>(state.range(1)) == 0 ? daqu::current_numa_node() : daqu::numa_node_count() - 1 - daqu::current_numa_node();
+    buffT     buffer{daqu::placement_allocator<value_type>(daqu::placement{node})};
+    fill_jittered(buffer, state.range(0));
+
+    std::mt19937                           gen(42);
+    std::uniform_int_distribution<int64_t> ts(0, buffer.back().ts.time_since_epoch().count());
+    std::vector<jittered_tp>               queries(1 << 12);
+    std::generate(queries.begin(), queries.end(), [&]() { return jittered_tp{std::chrono::microseconds(ts(gen))}; });
+
+    std::size_t i = 0;
+    for (auto _ : state)
+    {
+      benchmark::DoNotOptimize(daqu::access(buffer).get(queries[i++ & (queries.size() - 1)]));
+    }
+    state.SetLabel(state.range(1) == 0 ? "local" : "remote");
+  }
+} // namespace
+
+BENCHMARK(BM_placement_get_random_queries)->Args({1 << 20, 0})->Args({1 << 20, 1})->Args({1 << 24, 0})->Args({1 << 24, 1});
+
+/*
+ *
+ * Benchmark replay throughput as fast as possible, argument is (samples per stream, streams)
+ *
+ */
+namespace
+{
+  void BM_replay_as_fast_as_possible(benchmark::State& state)
+  {
+    // Perform setup here
+    using tp         = std::chrono::time_point<std::chrono::steady_clock, std::chrono::microseconds>;
+    using value_type = daqu::stamped_data<int, tp>;
+
+    const auto                           streams = static_cast<std::size_t>(state.range(1));
+    std::vector<std::vector<value_type>> recorded(streams), live(streams);
+    daqu::replayer<tp>                   replay;
+    for (std::size_t s = 0; s < streams; ++s)
+    {
+      for (int i = 0; i < state.range(0); ++i)
+        recorded[s].emplace_back(i, tp{std::chrono::microseconds(i * 10 + static_cast<int>(s))});
+      live[s].reserve(recorded[s].size());
+      replay.add_stream(recorded[s], live[s]);
+    }
+
+    for (auto _ : state)
+    {
+      for (auto& l : live)
+        l.clear();
+      benchmark::DoNotOptimize(replay.run());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0) * state.range(1));
+  }
+} // namespace
+
+BENCHMARK(BM_replay_as_fast_as_possible)->Args({1 << 20, 1})->Args({1 << 18, 4})->Args({1 << 16, 16});
+
+/*
+ *
+ * Benchmark get_data_inter copy vs reference result on exact hits with heap owning payload
+ *
+ */
+namespace
+{
+  template <bool by_ref>
+  void BM_string_payload_exact_hits(benchmark::State& state)
+  {
+    // Perform setup here
+    using tp         = std::chrono::time_point<std::chrono::steady_clock, std::chrono::microseconds>;
+    using value_type = daqu::stamped_data<std::string, tp>;
+
+    std::vector<value_type> buffer;
+    for (int i = 0; i < state.range(0); ++i)
+      buffer.emplace_back(std::string(256, static_cast<char>('a' + i % 26)), tp{std::chrono::microseconds(i * 10)});
+
+    std::mt19937                       gen(42);
+    std::uniform_int_distribution<int> idx(0, static_cast<int>(state.range(0)) - 1);
+    std::vector<tp>                    queries(1 << 12);
+    std::generate(queries.begin(), queries.end(), [&]() { return tp{std::chrono::microseconds(idx(gen) * 10)}; });
+
+    auto        accessor = daqu::access(buffer);
+    std::size_t i        = 0;
+    for (auto _ : state)
+    {
+      const tp& ts = queries[i++ & (queries.size() - 1)];
+      if constexpr (by_ref)
+        benchmark::DoNotOptimize(accessor.get_data_ref(accessor.get(ts), ts)->data.size());
+      else
+        benchmark::DoNotOptimize(accessor.get_data_inter(accessor.get(ts), ts).data.size());
+    }
+  }
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_string_payload_exact_hits, false)->Arg(1 << 10)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_string_payload_exact_hits, true)->Arg(1 << 10)->Arg(1 << 16);
 
 BENCHMARK_MAIN();
\ No newline at end of file
@@ -0,0 +1,457 @@
+#include <gtest/gtest.h>
+
+#include <data_queue/alignment_scheduler.h>
+#include <data_queue/data_queue.h>
+#include <data_queue/learned_index.h>
+#include <data_queue/placement.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+using tp = std::chrono::time_point<std::chrono::steady_clock, std::chrono::nanoseconds>;
+namespace daqu
+{
+  template <>
+  float extract(const tp::duration& value)
+  {
+    return static_cast<float>(value.count());
+  }
+
+} // namespace daqu
+
+namespace
+{
+  using ns         = std::chrono::nanoseconds;
+  using value_type = daqu::stamped_data<float, tp>;
+  using buffT      = std::vector<value_type>;
+
+  struct linear_interpolation
+  {
+    value_type operator()(const value_type& l, const float w0, const value_type& r, const float w1, const tp& ts) const
+    {
+      return {l.data * w1 + r.data * w0, ts};
+    }
+  };
+
+  /// \brief buffers per property, DATA_QUEUE_FUZZ_ITERATIONS overrides it for longer runs
+  int iterations()
+  {
+    const char* env = std::getenv("DATA_QUEUE_FUZZ_ITERATIONS");
+    return env ? std::max(1, std::atoi(env)) : 200;
+  }
+
+  /// \brief sorted buffer with duplicated stamps, jitter and gaps
+  buffT random_buffer(std::mt19937& gen)
+  {
+    std::uniform_int_distribution<int>    size(0, 300), kind(0, 99), jitter(-40, 40), gap(1000, 20000);
+    std::uniform_real_distribution<float> value(-100.f, 100.f);
+
+    buffT        buffer;
+    const int    n  = size(gen);
+    std::int64_t ts = std::uniform_int_distribution<std::int64_t>(-10000, 10000)(gen);
+    for (int i = 0; i < n; ++i)
+    {
+      const int k = kind(gen);
+      if (i > 0)
+        ts += k < 15 ? 0 : k < 20 ? gap(gen) : 100 + jitter(gen);
+      buffer.emplace_back(value(gen), tp{ns{ts}});
+    }
+    return buffer;
+  }
+
+  /// \brief stored stamps, their neighbours and midpoints, and random stamps around the buffer
+  std::vector<tp> random_queries(const buffT& buffer, std::mt19937& gen)
+  {
+    std::vector<tp> queries;
+    for (const auto& s : buffer)
+    {
+      queries.push_back(s.ts);
+      queries.push_back(s.ts - ns{1});
+      queries.push_back(s.ts + ns{1});
+    }
+    for (std::size_t i = 1; i < buffer.size(); ++i)
+      queries.push_back(buffer[i - 1].ts + (buffer[i].ts - buffer[i - 1].ts) / 2);
+
+    const std::int64_t lo = buffer.empty() ? 0 : buffer.front().ts.time_since_epoch().count() - 1000;
+    const std::int64_t hi = buffer.empty() ? 0 : buffer.back().ts.time_since_epoch().count() + 1000;
+
+    std::uniform_int_distribution<std::int64_t> ts(lo, hi);
+    for (int i = 0; i < 100; ++i)
+      queries.push_back(tp{ns{ts(gen)}});
+
+    std::shuffle(queries.begin(), queries.end(), gen);
+    return queries;
+  }
+
+  ns distance(const tp& a, const tp& b) { return a < b ? b - a : a - b; }
+
+  /// \brief smallest distance of a stored stamp to ts
+  ns ref_nearest_distance(const buffT& buffer, const tp& ts)
+  {
+    ns best = ns::max();
+    for (const auto& s : buffer)
+      best = std::min(best, distance(s.ts, ts));
+    return best;
+  }
+
+  /// \brief current contract of in_range: more than two samples and ts within the stamps
+  bool ref_in_range(const buffT& buffer, const tp& ts) { return buffer.size() > 2 && !(ts < buffer.front().ts) && !(buffer.back().ts < ts); }
+
+  /// \brief index of the sample returned without interpolation, -1 when ts lies between two samples
+  /// Exact hits return the first of equal stamps, stamps outside of the buffer the closest end.
+  std::ptrdiff_t ref_sample(const buffT& buffer, const tp& ts)
+  {
+    for (std::size_t i = 0; i < buffer.size(); ++i)
+      if (buffer[i].ts == ts)
+        return static_cast<std::ptrdiff_t>(i);
+    if (ts < buffer.front().ts)
+      return 0;
+    if (buffer.back().ts < ts)
+      return static_cast<std::ptrdiff_t>(buffer.size()) - 1;
+    return -1;
+  }
+
+  /// \brief linear interpolation between the closest stamps on both sides of ts
+  double ref_interpolation(const buffT& buffer, const tp& ts)
+  {
+    const auto s = ref_sample(buffer, ts);
+    if (s >= 0)
+      return static_cast<double>(buffer[static_cast<std::size_t>(s)].data);
+
+    std::size_t l = 0;
+    while (buffer[l + 1].ts < ts)
+      ++l;
+    const value_type& a = buffer[l];
+    const value_type& b = buffer[l + 1];
+    const double      w = static_cast<double>((ts - a.ts).count()) / static_cast<double>((b.ts - a.ts).count());
+    return static_cast<double>(a.data) * (1. - w) + static_cast<double>(b.data) * w;
+  }
+} // namespace
+
+TEST(property, nearest_and_threshold_test)
+{
+  std::mt19937 gen(1);
+  for (int it = 0; it < iterations(); ++it)
+  {
+    SCOPED_TRACE(it);
+    buffT buffer   = random_buffer(gen);
+    auto  accessor = daqu::access(buffer);
+
+    for (const tp& ts : random_queries(buffer, gen))
+    {
+      const auto nearest = accessor.get(ts);
+      if (buffer.empty())
+      {
+        ASSERT_EQ(nearest, buffer.end());
+        EXPECT_EQ(accessor.get(ts, ns{100}).status, daqu::storage_access_status::not_enough_elements);
+        continue;
+      }
+
+      // ties may resolve to either side, compare by distance
+      const ns best = ref_nearest_distance(buffer, ts);
+      ASSERT_NE(nearest, buffer.end());
+      ASSERT_EQ(distance(nearest->ts, ts), best);
+
+      for (const ns max_diff : {ns{0}, ns{1}, ns{50}, ns{200}, ns{5000}})
+      {
+        const auto res = accessor.get(ts, max_diff);
+        EXPECT_EQ(res.it, nearest);
+        EXPECT_EQ(res.time_diff, best);
+        EXPECT_EQ(res.status,
+                  best <= max_diff ? daqu::storage_access_status::success : daqu::storage_access_status::timestamp_diff_larger_then_thresh);
+      }
+    }
+  }
+}
+
+TEST(property, in_range_test)
+{
+  std::mt19937 gen(2);
+  for (int it = 0; it < iterations(); ++it)
+  {
+    SCOPED_TRACE(it);
+    buffT buffer   = random_buffer(gen);
+    auto  accessor = daqu::access(buffer);
+
+    for (const tp& ts : random_queries(buffer, gen))
+      ASSERT_EQ(accessor.in_range(ts), ref_in_range(buffer, ts));
+  }
+}
+
+TEST(property, interpolation_test)
+{
+  std::mt19937 gen(3);
+  for (int it = 0; it < iterations(); ++it)
+  {
+    SCOPED_TRACE(it);
+    buffT buffer = random_buffer(gen);
+    if (buffer.empty())
+      continue;
+    auto accessor = daqu::access(buffer);
+
+    value_type out{};
+    for (const tp& ts : random_queries(buffer, gen))
+    {
+      const double expected = ref_interpolation(buffer, ts);
+      const auto   sample   = ref_sample(buffer, ts);
+      const auto   nearest  = accessor.get(ts);
+
+      const value_type value = accessor.get_data_inter(nearest, ts, linear_interpolation());
+      ASSERT_NEAR(static_cast<double>(value.data), expected, 1e-3);
+
+      // copy free variants agree and reference the stored sample when not interpolating
+      const auto ref = accessor.get_data_ref(nearest, ts, linear_interpolation());
+      EXPECT_EQ(ref->data, value.data);
+      EXPECT_EQ(ref.interpolated(), sample < 0);
+      if (sample >= 0)
+      {
+        EXPECT_EQ(&ref.get(), &buffer[static_cast<std::size_t>(sample)]);
+      }
+      EXPECT_EQ(accessor.get_data_inter_into(nearest, ts, out, linear_interpolation()).data, value.data);
+
+      // precomputed bracket interpolates the same pair
+      const auto b = accessor.get_bracket(ts);
+      EXPECT_NEAR(static_cast<double>(accessor.get_data_inter(b, linear_interpolation()).data), expected, 1e-3);
+      EXPECT_EQ(b.left == b.right, sample >= 0);
+    }
+  }
+}
+
+TEST(property, batch_test)
+{
+  std::mt19937 gen(4);
+  for (int it = 0; it < iterations(); ++it)
+  {
+    SCOPED_TRACE(it);
+    buffT buffer   = random_buffer(gen);
+    auto  accessor = daqu::access(buffer);
+
+    using result = decltype(accessor)::result;
+
+    std::vector<tp> queries = random_queries(buffer, gen);
+    std::vector<tp> sorted  = queries;
+    std::sort(sorted.begin(), sorted.end());
+
+    // galloping search of ascending queries and random order give the single query results
+    for (const auto* q : {&queries, &sorted})
+    {
+      std::vector<result> bulk;
+      accessor.get(q->begin(), q->end(), ns{150}, std::back_inserter(bulk));
+      ASSERT_EQ(bulk.size(), q->size());
+
+      for (std::size_t i = 0; i < q->size(); ++i)
+      {
+        const auto single = accessor.get((*q)[i], ns{150});
+        ASSERT_EQ(bulk[i].it, single.it);
+        ASSERT_EQ(bulk[i].status, single.status);
+        if (single.it != buffer.end())
+        {
+          ASSERT_EQ(bulk[i].time_diff, single.time_diff);
+        }
+      }
+    }
+
+    std::vector<std::uint64_t> mask;
+    accessor.in_range(queries.begin(), queries.end(), std::back_inserter(mask));
+    ASSERT_EQ(mask.size(), (queries.size() + 63) / 64);
+    for (std::size_t i = 0; i < queries.size(); ++i)
+      ASSERT_EQ((mask[i / 64] >> (i % 64)) & 1u, ref_in_range(buffer, queries[i]) ? 1u : 0u);
+  }
+}
+
+TEST(property, window_test)
+{
+  std::mt19937 gen(5);
+  for (int it = 0; it < iterations(); ++it)
+  {
+    SCOPED_TRACE(it);
+    buffT buffer   = random_buffer(gen);
+    auto  accessor = daqu::access(buffer);
+
+    for (const tp& ts : random_queries(buffer, gen))
+    {
+      for (const std::size_t k : {1u, 3u, 8u})
+      {
+        const auto w = accessor.get_nearest(ts, k);
+        ASSERT_EQ(w.status, buffer.size() >= k ? daqu::storage_access_status::success : daqu::storage_access_status::not_enough_elements);
+        if (buffer.empty())
+          continue;
+
+        ASSERT_EQ(static_cast<std::size_t>(std::distance(w.first, w.last)), std::min(k, buffer.size()));
+        ASSERT_EQ(distance(w.nearest->ts, ts), ref_nearest_distance(buffer, ts));
+
+        // no sample outside of the window is closer than one inside
+        ns inside{0}, outside = ns::max();
+        for (auto s = buffer.begin(); s != buffer.end(); ++s)
+        {
+          if (s >= w.first && s < w.last)
+            inside = std::max(inside, distance(s->ts, ts));
+          else
+            outside = std::min(outside, distance(s->ts, ts));
+        }
+        ASSERT_LE(inside, outside);
+      }
+    }
+  }
+}
+
+TEST(property, search_policies_test)
+{
+  std::mt19937 gen(6);
+  for (int it = 0; it < iterations(); ++it)
+  {
+    SCOPED_TRACE(it);
+    buffT buffer = random_buffer(gen);
+
+    // indexes are built on half of the buffer, coarse stays stale to cover samples not indexed yet
+    const std::size_t built = buffer.size() / 2;
+    buffT             tail(buffer.begin() + static_cast<std::ptrdiff_t>(built), buffer.end());
+    buffer.resize(built);
+
+    daqu::learned_index<buffT>      fine(buffer, 2), coarse(buffer, 64);
+    daqu::timestamp_replicas<buffT> replicas(buffer, 2);
+    buffer.insert(buffer.end(), tail.begin(), tail.end());
+    fine.update();
+    replicas.update();
+
+    auto accessor = daqu::access(buffer);
+    for (const tp& ts : random_queries(buffer, gen))
+    {
+      const auto expected = accessor.get(ts);
+      ASSERT_EQ(daqu::access(buffer, std::cref(fine)).get(ts), expected);
+      ASSERT_EQ(daqu::access(buffer, std::cref(coarse)).get(ts), expected);
+      ASSERT_EQ(daqu::access(buffer, std::cref(replicas)).get(ts), expected);
+      ASSERT_EQ(daqu::access(buffer, daqu::prefetch_search()).get(ts), expected);
+    }
+  }
+}
+
+TEST(stress, locked_producer_readers_test)
+{
+  constexpr int      samples   = 5000;
+  constexpr unsigned readers   = 3;
+  constexpr int      min_reads = 2000;
+
+  std::deque<value_type> buffer;
+  std::shared_mutex      m;
+  std::atomic<bool>      done{false};
+  std::atomic<int>       failures{0};
+  std::atomic<int>       reads[readers] = {};
+
+  // producer keeps appending until every reader checked enough lookups against a growing buffer
+  std::thread producer([&]() {
+    const auto read_enough = [&]() { return std::all_of(std::begin(reads), std::end(reads), [](const auto& n) { return n >= min_reads; }); };
+    for (int i = 0; i < samples || !read_enough(); ++i)
+    {
+      std::unique_lock<std::shared_mutex> lock(m);
+      // every fourth stamp is duplicated
+      buffer.emplace_back(static_cast<float>(i), tp{ns{(i - i % 4 / 3) * 10}});
+    }
+    done = true;
+  });
+
+  std::vector<std::thread> threads;
+  for (unsigned r = 0; r < readers; ++r)
+    threads.emplace_back([&, r]() {
+      std::mt19937 gen(r);
+      // yield between reads, readers would starve the producer of the reader preferring lock otherwise
+      for (; !done; std::this_thread::yield())
+      {
+        std::shared_lock<std::shared_mutex> lock(m);
+        if (buffer.size() < 2)
+          continue;
+
+        const auto back = buffer.back().ts.time_since_epoch().count();
+        const tp   ts{ns{std::uniform_int_distribution<std::int64_t>(-100, back + 100)(gen)}};
+        auto       accessor = daqu::access(buffer);
+        const auto nearest  = accessor.get(ts);
+
+        // nearest is not farther than its neighbours
+        bool ok = nearest != buffer.end();
+        if (ok && nearest != buffer.begin())
+          ok = distance(nearest->ts, ts) <= distance(std::prev(nearest)->ts, ts);
+        if (ok && std::next(nearest) != buffer.end())
+          ok = distance(nearest->ts, ts) <= distance(std::next(nearest)->ts, ts);
+        ok = ok && accessor.in_range(ts) == (buffer.size() > 2 && !(ts < buffer.front().ts) && !(buffer.back().ts < ts));
+        if (!ok)
+          ++failures;
+        ++reads[r];
+      }
+    });
+
+  producer.join();
+  for (auto& t : threads)
+    t.join();
+  EXPECT_EQ(failures, 0);
+  EXPECT_GE(buffer.size(), static_cast<std::size_t>(samples));
+  for (const auto& n : reads)
+    EXPECT_GE(n, min_reads);
+}
+
+TEST(stress, alignment_scheduler_producers_test)
+{
+  struct stream
+  {
+    std::deque<value_type> buffer;
+    std::mutex             m;
+  };
+
+  constexpr int    samples = 5000;
+  stream           streams[2];
+  std::mutex       checked_m;
+  std::vector<tp>  checked;
+  std::atomic<int> failures{0};
+
+  {
+    daqu::thread_pool             pool(2);
+    daqu::alignment_scheduler<tp> scheduler(pool);
+    const std::size_t             ids[] = {scheduler.add_stream(), scheduler.add_stream()};
+
+    // every requested stamp has been appended to both streams once the callback runs
+    const auto consumer = scheduler.add_consumer({ids[0], ids[1]}, [&](const tp& ts) {
+      for (auto& st : streams)
+      {
+        std::lock_guard<std::mutex> lock(st.m);
+        auto                        accessor = daqu::access(st.buffer);
+        if (!accessor.in_range(ts) || accessor.get(ts)->ts != ts)
+          ++failures;
+      }
+      std::lock_guard<std::mutex> lock(checked_m);
+      checked.push_back(ts);
+    });
+
+    for (int i = 10; i < samples; i += 97)
+      scheduler.request(consumer, tp{ns{i * 10}});
+
+    std::vector<std::thread> producers;
+    for (std::size_t p = 0; p < 2; ++p)
+      producers.emplace_back([&, p]() {
+        for (int i = 0; i < samples; ++i)
+        {
+          const tp ts{ns{i * 10}};
+          {
+            std::lock_guard<std::mutex> lock(streams[p].m);
+            streams[p].buffer.emplace_back(static_cast<float>(i), ts);
+          }
+          scheduler.commit(ids[p], ts);
+        }
+      });
+
+    for (auto& t : producers)
+      t.join();
+    pool.wait();
+  }
+
+  EXPECT_EQ(failures, 0);
+  ASSERT_EQ(checked.size(), static_cast<std::size_t>((samples - 10 + 96) / 97));
+  EXPECT_TRUE(std::is_sorted(checked.begin(), checked.end()));
+}
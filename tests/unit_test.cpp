@@ -1,8 +1,27 @@
 #include <gtest/gtest.h>
 
+#include <data_queue/alignment_scheduler.h>
+#include <data_queue/checkpoint.h>
+#include <data_queue/clock_domain.h>
 #include <data_queue/data_queue.h>
+#include <data_queue/interpolation_cache.h>
+#include <data_queue/learned_index.h>
+#include <data_queue/multichannel.h>
+#include <data_queue/placement.h>
+#include <data_queue/pyramid.h>
+#include <data_queue/replay.h>
 
+#include <array>
 #include <chrono>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <random>
+#include <string>
 #include <thread>
 
 using tp = std::chrono::time_point<std::chrono::steady_clock, std::chrono::nanoseconds>;
@@ -14,6 +33,23 @@ namespace daqu
     return value.count();
   }
 
+  template <>
+  bool write_payload(std::ostream& os, const std::string& value)
+  {
+    const std::uint64_t n = value.size();
+    return os.write(reinterpret_cast<const char*>(&n), sizeof(n)) && os.write(value.data(), static_cast<std::streamsize>(n));
+  }
+
+  template <>
+  bool read_payload(std::istream& is, std::string& value)
+  {
+    std::uint64_t n = 0;
+    if (!is.read(reinterpret_cast<char*>(&n), sizeof(n)))
+      return false;
+    value.resize(n);
+    return static_cast<bool>(is.read(value.data(), static_cast<std::streamsize>(n)));
+  }
+
 } // namespace daqu
 
 TEST(storage_data_accessor, exact_access_test)
@@ -220,4 +256,1090 @@ TEST(storage_data_accessor, in_range_test)
 
   EXPECT_EQ(daqu::access(buffer).in_range(tp{std::chrono::nanoseconds{201}}), false);
   EXPECT_EQ(daqu::access(buffer).in_range(tp{std::chrono::nanoseconds{301}}), false);
-}
\ No newline at end of file
+}
+
+TEST(storage_data_accessor, nearest_k_test)
+{
+  using buffT = std::vector<daqu::stamped_data<int, tp>>;
+  buffT buffer;
+
+  {
+    auto r0 = daqu::access(buffer).get_nearest(tp{std::chrono::nanoseconds{0}}, 2);
+    EXPECT_EQ(r0.status, daqu::storage_access_status::not_enough_elements);
+    EXPECT_EQ(r0.first, r0.last);
+  }
+
+  buffer.emplace_back(10, tp{std::chrono::nanoseconds{0}});
+  buffer.emplace_back(20, tp{std::chrono::nanoseconds{100}});
+  buffer.emplace_back(30, tp{std::chrono::nanoseconds{200}});
+  buffer.emplace_back(40, tp{std::chrono::nanoseconds{300}});
+
+  {
+    auto r0 = daqu::access(buffer).get_nearest(tp{std::chrono::nanoseconds{120}}, 2);
+    EXPECT_EQ(r0.status, daqu::storage_access_status::success);
+    EXPECT_EQ(r0.nearest->data, 20);
+    EXPECT_EQ(r0.time_diff, std::chrono::nanoseconds{20});
+    EXPECT_EQ(r0.first->data, 20);
+    EXPECT_EQ(std::distance(r0.first, r0.last), 2);
+  }
+
+  {
+    auto r0 = daqu::access(buffer).get_nearest(tp{std::chrono::nanoseconds{170}}, 3);
+    EXPECT_EQ(r0.nearest->data, 30);
+    EXPECT_EQ(r0.first->data, 20);
+    EXPECT_EQ(std::prev(r0.last)->data, 40);
+  }
+
+  {
+    auto r0 = daqu::access(buffer).get_nearest(tp{std::chrono::nanoseconds{400}}, 2);
+    EXPECT_EQ(r0.nearest->data, 40);
+    EXPECT_EQ(r0.first->data, 30);
+    EXPECT_EQ(r0.last, buffer.end());
+  }
+
+  {
+    auto r0 = daqu::access(buffer).get_nearest(tp{std::chrono::nanoseconds{150}}, 5);
+    EXPECT_EQ(r0.status, daqu::storage_access_status::not_enough_elements);
+    EXPECT_EQ(r0.nearest, daqu::access(buffer).get(tp{std::chrono::nanoseconds{150}}));
+    EXPECT_EQ(r0.first, buffer.begin());
+    EXPECT_EQ(r0.last, buffer.end());
+  }
+}
+
+TEST(storage_data_accessor, bracket_test)
+{
+  struct int_interpolation
+  {
+    daqu::stamped_data<int, tp> operator()(const daqu::stamped_data<int, tp>& l, const float w0, const daqu::stamped_data<int, tp>& r, const float w1,
+                                           const tp& tar_ts)
+    {
+      return daqu::stamped_data<int, tp>(int(float(l.data) * w1 + float(r.data) * w0), tar_ts);
+    }
+  };
+
+  using buffT = std::vector<daqu::stamped_data<int, tp>>;
+  buffT buffer;
+
+  buffer.emplace_back(10, tp{std::chrono::nanoseconds{0}});
+  buffer.emplace_back(20, tp{std::chrono::nanoseconds{100}});
+  buffer.emplace_back(30, tp{std::chrono::nanoseconds{200}});
+  buffer.emplace_back(40, tp{std::chrono::nanoseconds{300}});
+
+  {
+    auto b = daqu::access(buffer).get_bracket(tp{std::chrono::nanoseconds{125}}, 2);
+    EXPECT_EQ(b.status, daqu::storage_access_status::success);
+    EXPECT_EQ(b.left->data, 20);
+    EXPECT_EQ(b.right->data, 30);
+    EXPECT_EQ(b.first, buffer.begin());
+    EXPECT_EQ(b.last, buffer.end());
+    EXPECT_FLOAT_EQ(b.w0, 0.25f);
+    EXPECT_FLOAT_EQ(b.w1, 0.75f);
+    EXPECT_EQ(daqu::access(buffer).get_data_inter(b, int_interpolation()).data, 22);
+  }
+
+  {
+    auto b = daqu::access(buffer).get_bracket(tp{std::chrono::nanoseconds{50}}, 2);
+    EXPECT_EQ(b.status, daqu::storage_access_status::not_enough_elements);
+    EXPECT_EQ(b.first, buffer.begin());
+    EXPECT_EQ(std::distance(b.first, b.last), 3);
+  }
+
+  {
+    auto b = daqu::access(buffer).get_bracket(tp{std::chrono::nanoseconds{200}});
+    EXPECT_EQ(b.status, daqu::storage_access_status::success);
+    EXPECT_EQ(b.left, b.right);
+    EXPECT_EQ(daqu::access(buffer).get_data_inter(b, int_interpolation()).data, 30);
+
+    // exact hit needs k - 1 neighbours on each side
+    EXPECT_EQ(daqu::access(buffer).get_bracket(tp{std::chrono::nanoseconds{200}}, 2).status, daqu::storage_access_status::success);
+    EXPECT_EQ(daqu::access(buffer).get_bracket(tp{std::chrono::nanoseconds{300}}, 2).status, daqu::storage_access_status::not_enough_elements);
+    EXPECT_EQ(daqu::access(buffer).get_bracket(tp{std::chrono::nanoseconds{0}}).status, daqu::storage_access_status::success);
+  }
+
+  {
+    auto b = daqu::access(buffer).get_bracket(tp{std::chrono::nanoseconds{-5}});
+    EXPECT_EQ(b.status, daqu::storage_access_status::not_enough_elements);
+    EXPECT_EQ(b.left->data, 10);
+  }
+
+  {
+    auto b = daqu::access(buffer).get_bracket(tp{std::chrono::nanoseconds{500}});
+    EXPECT_EQ(b.status, daqu::storage_access_status::not_enough_elements);
+    EXPECT_EQ(b.left->data, 40);
+    EXPECT_EQ(daqu::access(buffer).get_data_inter(b).data, 40);
+  }
+}
+
+TEST(learned_index, matches_lower_bound_test)
+{
+  using buffT = std::vector<daqu::stamped_data<int, tp>>;
+  buffT buffer;
+
+  std::mt19937                       gen(42);
+  std::uniform_int_distribution<int> step(0, 40);
+
+  daqu::learned_index<buffT> index(buffer, 4);
+
+  auto check = [&]() {
+    const auto back = buffer.back().ts.time_since_epoch().count();
+    for (long i = -10; i < back + 10; ++i)
+    {
+      const tp ts{std::chrono::nanoseconds{i}};
+      EXPECT_EQ(daqu::access(buffer, std::cref(index)).get(ts), daqu::access(buffer).get(ts));
+      EXPECT_EQ(std::cref(index)(buffer, ts), daqu::lower_bound_search()(buffer, ts));
+      EXPECT_EQ(daqu::prefetch_search()(buffer, ts), daqu::lower_bound_search()(buffer, ts));
+    }
+  };
+
+  long t = 0;
+  for (int i = 0; i < 2000; ++i)
+  {
+    // bursts of duplicates, jitter and gaps
+    t += i % 100 == 0 ? 1000 : step(gen) / 10;
+    buffer.emplace_back(i, tp{std::chrono::nanoseconds{t}});
+  }
+
+  index.update();
+  EXPECT_EQ(index.size(), buffer.size());
+  EXPECT_LT(index.segments().size(), buffer.size() / 4);
+  check();
+
+  // samples appended after update are still found
+  buffer.emplace_back(0, tp{std::chrono::nanoseconds{t + 5}});
+  check();
+
+  index.update();
+  check();
+
+  buffer.resize(100);
+  index.update();
+  EXPECT_EQ(index.size(), 100u);
+  check();
+}
+
+TEST(learned_index, sliding_window_test)
+{
+  using ns    = std::chrono::nanoseconds;
+  using buffT = std::deque<daqu::stamped_data<int, tp>>;
+
+  // queue of 500 samples with duplicated stamps and occasional gaps
+  buffT buffer;
+  long  t = 0;
+  int   i = 0;
+  auto  push = [&]() {
+    t += i % 5 == 0 ? 0 : i % 97 == 0 ? 5000 : 10;
+    buffer.emplace_back(i++, tp{ns{t}});
+  };
+  for (int n = 0; n < 500; ++n)
+    push();
+
+  daqu::learned_index<buffT> index(buffer, 8);
+  const auto                 check = [&]() {
+    for (long ts = buffer.front().ts.time_since_epoch().count() - 7; ts < t + 20; ts += 13)
+      ASSERT_EQ(daqu::access(buffer, std::cref(index)).get(tp{ns{ts}}), daqu::access(buffer).get(tp{ns{ts}})) << ts;
+  };
+
+  for (int step = 0; step < 2000; ++step)
+  {
+    push();
+    buffer.pop_front();
+    if (step % 11 != 0)
+    {
+      index.update();
+      ASSERT_EQ(index.size(), buffer.size());
+    }
+    if (step % 50 == 0)
+      check();
+  }
+
+  // obsolete segments are dropped, only segments reaching the front are kept
+  index.update();
+  EXPECT_LE(index.segments().front().key, buffer.front().ts.time_since_epoch().count());
+  EXPECT_LT(index.segments().size(), buffer.size() / 4);
+
+  // shrinking without update stays within the container
+  buffer.erase(buffer.begin(), buffer.begin() + 400);
+  buffer.resize(50);
+  check();
+
+  index.update();
+  EXPECT_EQ(index.size(), 50u);
+  check();
+}
+
+TEST(clock_mapping, drift_and_offset_test)
+{
+  using host_tp = std::chrono::time_point<std::chrono::system_clock, std::chrono::microseconds>;
+
+  daqu::clock_mapping<tp, host_tp> mapping;
+  EXPECT_FALSE(mapping.valid());
+
+  // device counts nanoseconds 100 ppm fast, host is 5 s ahead
+  const host_tp host0{std::chrono::seconds{5}};
+  for (long i = 0; i <= 100; ++i)
+    mapping.add(tp{std::chrono::nanoseconds{i * 10001000}}, host0 + std::chrono::microseconds{i * 10000});
+
+  EXPECT_EQ(mapping.observations(), 101u);
+  EXPECT_NEAR(mapping.drift(), 1. / 1000 / 1.0001, 1e-9);
+  EXPECT_EQ(mapping.to_target(tp{std::chrono::nanoseconds{500050000}}), host0 + std::chrono::microseconds{500000});
+  EXPECT_EQ(mapping.to_source(host0 + std::chrono::microseconds{2000000}), tp{std::chrono::nanoseconds{2000200000}});
+
+  {
+    // single observation falls back to nominal ratio of periods
+    daqu::clock_mapping<tp, host_tp> offset_only;
+    offset_only.add(tp{std::chrono::nanoseconds{0}}, host0);
+    EXPECT_DOUBLE_EQ(offset_only.drift(), 1e-3);
+    EXPECT_EQ(offset_only.to_target(tp{std::chrono::nanoseconds{7000}}), host0 + std::chrono::microseconds{7});
+  }
+
+  using buffT = std::vector<daqu::stamped_data<int, tp>>;
+  buffT buffer;
+  buffer.emplace_back(10, tp{std::chrono::nanoseconds{0}});
+  buffer.emplace_back(20, tp{std::chrono::nanoseconds{100010000}});
+  buffer.emplace_back(30, tp{std::chrono::nanoseconds{200020000}});
+
+  auto device = daqu::access_in(buffer, mapping);
+  EXPECT_EQ(device.get(host0 + std::chrono::microseconds{100000})->data, 20);
+  EXPECT_EQ(device.get(host0 + std::chrono::microseconds{160000})->data, 30);
+  EXPECT_TRUE(device.in_range(host0 + std::chrono::microseconds{200000}));
+  EXPECT_FALSE(device.in_range(host0 + std::chrono::microseconds{200001}));
+
+  auto r0 = device.get(host0 + std::chrono::microseconds{100001}, std::chrono::nanoseconds{2000});
+  EXPECT_EQ(r0.status, daqu::storage_access_status::success);
+  EXPECT_EQ(r0.time_diff, std::chrono::nanoseconds{1000});
+}
+
+TEST(checkpoint, save_load_test)
+{
+  const std::string path = ::testing::TempDir() + "data_queue_checkpoint.bin";
+
+  {
+    using buffT = std::vector<daqu::stamped_data<int, tp>>;
+    buffT buffer;
+    for (int i = 0; i < 1000; ++i)
+      buffer.emplace_back(i, tp{std::chrono::nanoseconds{i * 10}});
+
+    EXPECT_EQ(daqu::save_checkpoint(buffer, path), daqu::checkpoint_status::success);
+
+    buffT restored{{-1, tp{}}};
+    EXPECT_EQ(daqu::load_checkpoint(restored, path), daqu::checkpoint_status::success);
+    ASSERT_EQ(restored.size(), buffer.size());
+    EXPECT_EQ(restored.back().data, 999);
+    EXPECT_EQ(restored.back().ts, buffer.back().ts);
+
+    // last samples only
+    EXPECT_EQ(daqu::save_checkpoint(buffer, path, tp{std::chrono::nanoseconds{9895}}), daqu::checkpoint_status::success);
+    EXPECT_EQ(daqu::load_checkpoint(restored, path), daqu::checkpoint_status::success);
+    ASSERT_EQ(restored.size(), 10u);
+    EXPECT_EQ(restored.front().data, 990);
+
+    // same file, element by element into non contiguous buffer
+    std::deque<daqu::stamped_data<int, tp>> dq;
+    EXPECT_EQ(daqu::load_checkpoint(dq, path), daqu::checkpoint_status::success);
+    ASSERT_EQ(dq.size(), 10u);
+    EXPECT_EQ(dq.front().data, 990);
+
+    // raw image is refused for another layout
+    std::vector<daqu::stamped_data<std::array<int, 4>, tp>> other;
+    EXPECT_EQ(daqu::load_checkpoint(other, path), daqu::checkpoint_status::bad_format);
+  }
+
+  {
+    using buffT = std::vector<daqu::stamped_data<std::string, tp>>;
+    buffT buffer;
+    buffer.emplace_back("one", tp{std::chrono::nanoseconds{1}});
+    buffer.emplace_back("", tp{std::chrono::nanoseconds{2}});
+    buffer.emplace_back("three", tp{std::chrono::nanoseconds{3}});
+
+    EXPECT_EQ(daqu::save_checkpoint(buffer, path), daqu::checkpoint_status::success);
+
+    buffT restored;
+    EXPECT_EQ(daqu::load_checkpoint(restored, path), daqu::checkpoint_status::success);
+    ASSERT_EQ(restored.size(), 3u);
+    EXPECT_EQ(restored[0].data, "one");
+    EXPECT_EQ(restored[1].data, "");
+    EXPECT_EQ(restored[2].data, "three");
+    EXPECT_EQ(restored[2].ts, tp{std::chrono::nanoseconds{3}});
+
+    std::vector<daqu::stamped_data<int, tp>> raw;
+    EXPECT_EQ(daqu::load_checkpoint(raw, path), daqu::checkpoint_status::bad_format);
+  }
+
+  {
+    std::vector<daqu::stamped_data<int, tp>> buffer;
+    EXPECT_EQ(daqu::load_checkpoint(buffer, path + ".missing"), daqu::checkpoint_status::io_error);
+  }
+
+  {
+    using buffT = std::vector<daqu::stamped_data<int, tp>>;
+    buffT buffer;
+    for (int i = 0; i < 10; ++i)
+      buffer.emplace_back(i, tp{std::chrono::nanoseconds{i}});
+    ASSERT_EQ(daqu::save_checkpoint(buffer, path), daqu::checkpoint_status::success);
+    EXPECT_FALSE(std::ifstream(path + ".tmp"));
+
+    // failed save keeps the previous checkpoint, a directory blocks the temporary file
+    const std::string blocked = ::testing::TempDir() + "data_queue_blocked.bin";
+    ASSERT_EQ(daqu::save_checkpoint(buffer, blocked), daqu::checkpoint_status::success);
+    std::filesystem::create_directory(blocked + ".tmp");
+    EXPECT_EQ(daqu::save_checkpoint(buffT{}, blocked), daqu::checkpoint_status::io_error);
+    buffT previous;
+    EXPECT_EQ(daqu::load_checkpoint(previous, blocked), daqu::checkpoint_status::success);
+    EXPECT_EQ(previous.size(), buffer.size());
+    std::filesystem::remove(blocked + ".tmp");
+
+    // corrupted count is refused before allocating
+    for (const std::uint64_t count : {std::uint64_t(11), std::uint64_t(1) << 60, ~std::uint64_t(0)})
+    {
+      {
+        std::fstream fs(path, std::ios::binary | std::ios::in | std::ios::out);
+        fs.seekp(16);
+        fs.write(reinterpret_cast<const char*>(&count), sizeof(count));
+      }
+      buffT restored{{-1, tp{}}};
+      EXPECT_EQ(daqu::load_checkpoint(restored, path), daqu::checkpoint_status::bad_format);
+
+      std::deque<daqu::stamped_data<int, tp>> dq;
+      EXPECT_EQ(daqu::load_checkpoint(dq, path), daqu::checkpoint_status::bad_format);
+    }
+
+    std::vector<daqu::stamped_data<std::string, tp>> strings{{"one", tp{}}};
+    ASSERT_EQ(daqu::save_checkpoint(strings, path), daqu::checkpoint_status::success);
+    {
+      const std::uint64_t count = std::uint64_t(1) << 60;
+      std::fstream        fs(path, std::ios::binary | std::ios::in | std::ios::out);
+      fs.seekp(16);
+      fs.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    }
+    EXPECT_EQ(daqu::load_checkpoint(strings, path), daqu::checkpoint_status::bad_format);
+  }
+}
+
+TEST(storage_data_accessor, deadline_test)
+{
+  struct int_interpolation
+  {
+    daqu::stamped_data<int, tp> operator()(const daqu::stamped_data<int, tp>& l, const float w0, const daqu::stamped_data<int, tp>& r, const float w1,
+                                           const tp& tar_ts)
+    {
+      return daqu::stamped_data<int, tp>(int(float(l.data) * w1 + float(r.data) * w0), tar_ts);
+    }
+  };
+
+  using buffT = std::vector<daqu::stamped_data<int, tp>>;
+  buffT buffer;
+
+  const auto now = std::chrono::steady_clock::now();
+  const daqu::deadline<> relaxed{now + std::chrono::hours{1}};
+  const daqu::deadline<> expired{now - std::chrono::seconds{1}};
+  const daqu::deadline<> tight{now + std::chrono::hours{1}, std::chrono::hours{2}};
+
+  {
+    auto r0 = daqu::access(buffer).get_data_inter(tp{std::chrono::nanoseconds{50}}, relaxed);
+    EXPECT_EQ(r0.status, daqu::storage_access_status::not_enough_elements);
+    EXPECT_EQ(r0.it, buffer.end());
+  }
+
+  buffer.emplace_back(10, tp{std::chrono::nanoseconds{0}});
+  buffer.emplace_back(20, tp{std::chrono::nanoseconds{100}});
+  buffer.emplace_back(30, tp{std::chrono::nanoseconds{200}});
+
+  {
+    auto r0 = daqu::access(buffer).get_data_inter(tp{std::chrono::nanoseconds{50}}, relaxed, int_interpolation());
+    EXPECT_EQ(r0.status, daqu::storage_access_status::success);
+    EXPECT_EQ(r0.value.data, 15);
+  }
+
+  {
+    // late queries still get the nearest sample
+    auto r0 = daqu::access(buffer).get_data_inter(tp{std::chrono::nanoseconds{40}}, expired, int_interpolation());
+    EXPECT_EQ(r0.status, daqu::storage_access_status::deadline_exceeded);
+    EXPECT_EQ(r0.it, buffer.begin());
+    EXPECT_EQ(r0.value.data, 10);
+
+    auto r1 = daqu::access(buffer).get_data_inter(tp{std::chrono::nanoseconds{100}}, expired, int_interpolation());
+    EXPECT_EQ(r1.status, daqu::storage_access_status::deadline_exceeded);
+    EXPECT_EQ(r1.value.data, 20);
+  }
+
+  {
+    // edge clamps are not successful, whatever the deadline
+    auto r0 = daqu::access(buffer).get_data_inter(tp{std::chrono::nanoseconds{300}}, relaxed, int_interpolation());
+    EXPECT_EQ(r0.status, daqu::storage_access_status::not_enough_elements);
+    EXPECT_EQ(r0.value.data, 30);
+
+    auto r1 = daqu::access(buffer).get_data_inter(tp{std::chrono::nanoseconds{-10}}, expired, int_interpolation());
+    EXPECT_EQ(r1.status, daqu::storage_access_status::not_enough_elements);
+    EXPECT_EQ(r1.it, buffer.begin());
+    EXPECT_EQ(r1.value.data, 10);
+  }
+
+  {
+    auto r0 = daqu::access(buffer).get_data_inter(tp{std::chrono::nanoseconds{140}}, tight, int_interpolation());
+    EXPECT_EQ(r0.status, daqu::storage_access_status::interpolation_skipped_by_deadline);
+    EXPECT_EQ(r0.value.data, 20);
+
+    auto r1 = daqu::access(buffer).get_data_inter(tp{std::chrono::nanoseconds{150}}, tight, int_interpolation());
+    EXPECT_EQ(r1.value.data, daqu::access(buffer).get(tp{std::chrono::nanoseconds{150}})->data);
+
+    // no interpolation needed, budget is irrelevant
+    auto r2 = daqu::access(buffer).get_data_inter(tp{std::chrono::nanoseconds{200}}, tight, int_interpolation());
+    EXPECT_EQ(r2.status, daqu::storage_access_status::success);
+    EXPECT_EQ(r2.value.data, 30);
+  }
+}
+
+TEST(multichannel_accessor, interpolation_test)
+{
+  daqu::multichannel_buffer<float, tp> buffer(4);
+
+  EXPECT_EQ(daqu::access(buffer).get(tp{std::chrono::nanoseconds{0}}), 0u);
+  EXPECT_EQ(daqu::access(buffer).get_bracket(tp{std::chrono::nanoseconds{0}}).status, daqu::storage_access_status::not_enough_elements);
+
+  const float s0[] = {0.f, 10.f, -4.f, 1.f};
+  const float s1[] = {1.f, 20.f, -8.f, 1.f};
+  const float s2[] = {2.f, 40.f, 0.f, 1.f};
+  buffer.push_back(tp{std::chrono::nanoseconds{0}}, s0);
+  buffer.push_back(tp{std::chrono::nanoseconds{100}}, s1);
+  buffer.push_back(tp{std::chrono::nanoseconds{200}}, s2);
+
+  EXPECT_EQ(buffer.size(), 3u);
+  EXPECT_EQ(buffer.column(1)[2], 40.f);
+
+  const auto acc = daqu::access(buffer);
+  EXPECT_EQ(acc.get(tp{std::chrono::nanoseconds{49}}), 0u);
+  EXPECT_EQ(acc.get(tp{std::chrono::nanoseconds{150}}), 2u);
+  EXPECT_EQ(acc.get(tp{std::chrono::nanoseconds{900}}), 2u);
+  EXPECT_TRUE(acc.in_range(tp{std::chrono::nanoseconds{200}}));
+  EXPECT_FALSE(acc.in_range(tp{std::chrono::nanoseconds{201}}));
+
+  {
+    std::vector<float> out;
+    acc.get_data_inter(tp{std::chrono::nanoseconds{125}}, std::back_inserter(out));
+    ASSERT_EQ(out.size(), 4u);
+    EXPECT_FLOAT_EQ(out[0], 1.25f);
+    EXPECT_FLOAT_EQ(out[1], 25.f);
+    EXPECT_FLOAT_EQ(out[2], -6.f);
+    EXPECT_FLOAT_EQ(out[3], 1.f);
+  }
+
+  {
+    const std::size_t  channels[] = {2, 1};
+    std::vector<float> out;
+    acc.get_data_inter(tp{std::chrono::nanoseconds{50}}, std::begin(channels), std::end(channels), std::back_inserter(out));
+    ASSERT_EQ(out.size(), 2u);
+    EXPECT_FLOAT_EQ(out[0], -6.f);
+    EXPECT_FLOAT_EQ(out[1], 15.f);
+  }
+
+  {
+    std::vector<decltype(acc)::bracket> brackets;
+    for (long ts : {-10L, 0L, 50L, 200L, 300L})
+      brackets.push_back(acc.get_bracket(tp{std::chrono::nanoseconds{ts}}));
+
+    // status agrees with storage_data_accessor::get_bracket, clamped values are still written
+    EXPECT_EQ(brackets[0].status, daqu::storage_access_status::not_enough_elements);
+    EXPECT_EQ(brackets[1].status, daqu::storage_access_status::success);
+    EXPECT_EQ(brackets[2].status, daqu::storage_access_status::success);
+    EXPECT_EQ(brackets[3].status, daqu::storage_access_status::success);
+    EXPECT_EQ(brackets[4].status, daqu::storage_access_status::not_enough_elements);
+
+    std::vector<float> out;
+    acc.get_column_inter(brackets.begin(), brackets.end(), 1, std::back_inserter(out));
+    EXPECT_EQ(out, (std::vector<float>{10.f, 10.f, 15.f, 40.f, 40.f}));
+  }
+}
+
+TEST(multichannel_accessor, sliding_window_test)
+{
+  daqu::multichannel_buffer<int, tp> buffer(2);
+
+  // window of 8 samples, values are ts and -ts
+  for (int i = 0; i < 100; ++i)
+  {
+    const int values[] = {i * 10, -i * 10};
+    buffer.push_back(tp{std::chrono::nanoseconds{i * 10}}, values);
+    if (buffer.size() > 8)
+      buffer.pop_front();
+
+    ASSERT_EQ(buffer.size(), std::min(i + 1, 8));
+    ASSERT_EQ(buffer.timestamps().front(), tp{std::chrono::nanoseconds{std::max(0, i - 7) * 10}});
+    ASSERT_EQ(buffer.column(1).back(), -i * 10);
+
+    const auto acc = daqu::access(buffer);
+    EXPECT_EQ(acc.get(tp{std::chrono::nanoseconds{i * 10 - 12}}), i < 2 ? 0u : buffer.size() - 2);
+
+    std::vector<int> out;
+    acc.get_data_inter(tp{std::chrono::nanoseconds{i * 10 - 5}}, std::back_inserter(out));
+    ASSERT_EQ(out.size(), 2u);
+    EXPECT_EQ(out[0], i == 0 ? 0 : i * 10 - 5);
+  }
+
+  // stamps before the new front are clamped to it
+  buffer.pop_front(5);
+  EXPECT_EQ(buffer.size(), 3u);
+  EXPECT_EQ(daqu::access(buffer).get_bracket(tp{std::chrono::nanoseconds{0}}).status, daqu::storage_access_status::not_enough_elements);
+  EXPECT_EQ(buffer.column(0)[0], 970);
+
+  buffer.pop_front(10);
+  EXPECT_TRUE(buffer.empty());
+  EXPECT_EQ(daqu::access(buffer).get(tp{std::chrono::nanoseconds{0}}), 0u);
+}
+
+TEST(interpolation_cache, hit_and_invalidation_test)
+{
+  struct counting_interpolation
+  {
+    int* calls;
+    daqu::stamped_data<int, tp> operator()(const daqu::stamped_data<int, tp>& l, const float w0, const daqu::stamped_data<int, tp>& r, const float w1,
+                                           const tp& tar_ts)
+    {
+      ++*calls;
+      return daqu::stamped_data<int, tp>(int(float(l.data) * w1 + float(r.data) * w0), tar_ts);
+    }
+  };
+
+  using buffT = std::deque<daqu::stamped_data<int, tp>>;
+  buffT buffer;
+  int   calls = 0;
+
+  daqu::interpolation_cache<buffT, counting_interpolation, 4> cache(buffer, counting_interpolation{&calls});
+  EXPECT_EQ(cache.get_data_inter(tp{std::chrono::nanoseconds{50}}).data, 0);
+
+  buffer.emplace_back(10, tp{std::chrono::nanoseconds{0}});
+  buffer.emplace_back(20, tp{std::chrono::nanoseconds{100}});
+  buffer.emplace_back(30, tp{std::chrono::nanoseconds{200}});
+
+  EXPECT_EQ(cache.get_data_inter(tp{std::chrono::nanoseconds{50}}).data, 15);
+  EXPECT_EQ(cache.get_data_inter(tp{std::chrono::nanoseconds{50}}).data, 15);
+  EXPECT_EQ(calls, 1);
+  EXPECT_EQ(cache.get_data_inter(tp{std::chrono::nanoseconds{300}}).data, 30);
+  EXPECT_EQ(cache.misses(), 3u);
+  EXPECT_EQ(cache.hits(), 1u);
+
+  // append keeps interior bracket, but changes the result past the back
+  buffer.emplace_back(40, tp{std::chrono::nanoseconds{400}});
+  EXPECT_EQ(cache.get_data_inter(tp{std::chrono::nanoseconds{50}}).data, 15);
+  EXPECT_EQ(cache.get_data_inter(tp{std::chrono::nanoseconds{300}}).data, 35);
+  EXPECT_EQ(cache.hits(), 2u);
+  EXPECT_EQ(calls, 2);
+
+  // eviction drops entries of evicted samples only
+  buffer.pop_front();
+  EXPECT_EQ(cache.get_data_inter(tp{std::chrono::nanoseconds{50}}).data, 20);
+  EXPECT_EQ(cache.get_data_inter(tp{std::chrono::nanoseconds{300}}).data, 35);
+  EXPECT_EQ(cache.hits(), 3u);
+  EXPECT_EQ(calls, 2);
+
+  // oldest entries are replaced when full
+  for (long ts : {110L, 120L, 130L, 140L})
+    cache.get_data_inter(tp{std::chrono::nanoseconds{ts}});
+  const auto misses = cache.misses();
+  cache.get_data_inter(tp{std::chrono::nanoseconds{50}});
+  EXPECT_EQ(cache.misses(), misses + 1);
+
+  cache.clear();
+  cache.get_data_inter(tp{std::chrono::nanoseconds{140}});
+  EXPECT_EQ(cache.misses(), misses + 2);
+}
+
+TEST(alignment_scheduler, dispatch_when_inputs_cover_test)
+{
+  daqu::thread_pool               pool(4);
+  daqu::alignment_scheduler<long> scheduler(pool);
+
+  const auto imu    = scheduler.add_stream();
+  const auto camera = scheduler.add_stream();
+  const auto lidar  = scheduler.add_stream();
+
+  std::mutex        m;
+  std::vector<long> fused;
+  std::vector<long> camera_only;
+
+  const auto fusion = scheduler.add_consumer({imu, camera, lidar}, [&](const long& ts) {
+    std::lock_guard<std::mutex> lock(m);
+    EXPECT_GE(*scheduler.watermark(imu), ts);
+    EXPECT_GE(*scheduler.watermark(camera), ts);
+    EXPECT_GE(*scheduler.watermark(lidar), ts);
+    fused.push_back(ts);
+  });
+  const auto viewer = scheduler.add_consumer({camera}, [&](const long& ts) {
+    std::lock_guard<std::mutex> lock(m);
+    camera_only.push_back(ts);
+  });
+
+  for (long ts = 0; ts < 1000; ts += 10)
+  {
+    scheduler.request(fusion, ts);
+    scheduler.request(viewer, ts);
+  }
+
+  scheduler.commit(camera, 5);
+  pool.wait();
+  {
+    std::lock_guard<std::mutex> lock(m);
+    EXPECT_TRUE(fused.empty());
+    EXPECT_EQ(camera_only, (std::vector<long>{0}));
+  }
+
+  std::vector<std::thread> producers;
+  for (auto s : {imu, camera, lidar})
+    producers.emplace_back([&scheduler, s]() {
+      for (long ts = 0; ts <= 2000; ts += 1 + static_cast<long>(s))
+        scheduler.commit(s, ts);
+    });
+  for (auto& t : producers)
+    t.join();
+  pool.wait();
+
+  std::lock_guard<std::mutex> lock(m);
+  ASSERT_EQ(fused.size(), 100u);
+  ASSERT_EQ(camera_only.size(), 100u);
+  EXPECT_TRUE(std::is_sorted(fused.begin(), fused.end()));
+  EXPECT_TRUE(std::is_sorted(camera_only.begin(), camera_only.end()));
+  EXPECT_EQ(fused.back(), 990);
+}
+
+TEST(thread_pool, nested_submit_test)
+{
+  std::atomic<int> count{0};
+  {
+    daqu::thread_pool pool(3);
+    for (int i = 0; i < 100; ++i)
+      pool.submit([&]() {
+        ++count;
+        pool.submit([&]() { ++count; });
+      });
+    pool.wait();
+    EXPECT_EQ(count, 200);
+  }
+}
+
+TEST(thread_pool, wait_for_nested_tasks_test)
+{
+  // wait() must not return while nested tasks are still queued or running
+  daqu::thread_pool pool(4);
+  for (int run = 0; run < 2000; ++run)
+  {
+    std::atomic<int> count{0};
+    for (int i = 0; i < 4; ++i)
+      pool.submit([&]() {
+        for (int j = 0; j < 20; ++j)
+          pool.submit([&]() { ++count; });
+      });
+    pool.wait();
+    ASSERT_EQ(count, 80) << "run " << run;
+  }
+}
+
+TEST(pyramid, incremental_query_test)
+{
+  using ns    = std::chrono::nanoseconds;
+  using buffT = std::vector<daqu::stamped_data<int, tp>>;
+  buffT buffer;
+
+  daqu::pyramid<buffT> pyr(buffer, 2, 10);
+
+  for (int i = 0; i < 250; ++i)
+    buffer.emplace_back(i % 7, tp{ns{i * 10}});
+  pyr.update();
+
+  ASSERT_EQ(pyr.levels(), 2u);
+  ASSERT_EQ(pyr.level(1).size(), 25u);
+  ASSERT_EQ(pyr.level(2).size(), 3u);
+  EXPECT_EQ(pyr.level(2).back().count, 50u);
+  EXPECT_EQ(pyr.level(1)[1].first_ts, tp{ns{100}});
+  EXPECT_EQ(pyr.level(1)[1].last_ts, tp{ns{190}});
+  EXPECT_EQ(pyr.level(1)[1].min, 0.f);
+  EXPECT_EQ(pyr.level(1)[1].max, 6.f);
+  EXPECT_FLOAT_EQ(pyr.level(1)[0].mean(), 2.4f);
+
+  using bucket = daqu::bucket<tp>;
+  {
+    std::vector<bucket> out;
+    const auto level = pyr.query(tp{ns{0}}, tp{ns{2490}}, ns{5}, std::back_inserter(out));
+    EXPECT_EQ(level, 0u);
+    EXPECT_EQ(out.size(), 250u);
+  }
+
+  {
+    std::vector<bucket> out;
+    const auto level = pyr.query(tp{ns{150}}, tp{ns{420}}, ns{100}, std::back_inserter(out));
+    EXPECT_EQ(level, 1u);
+    ASSERT_EQ(out.size(), 4u);
+    EXPECT_EQ(out.front().first_ts, tp{ns{100}});
+    EXPECT_EQ(out.back().first_ts, tp{ns{400}});
+  }
+
+  {
+    std::vector<bucket> out;
+    const auto level = pyr.query(tp{ns{0}}, tp{ns{10000}}, std::chrono::seconds{1}, std::back_inserter(out));
+    EXPECT_EQ(level, 2u);
+    EXPECT_EQ(out.size(), 3u);
+  }
+
+  // open buckets are extended by update
+  buffer.emplace_back(100, tp{ns{2500}});
+  pyr.update();
+  EXPECT_EQ(pyr.level(2).back().count, 51u);
+  EXPECT_EQ(pyr.level(2).back().max, 100.f);
+  EXPECT_EQ(pyr.level(1).back().count, 1u);
+
+  buffer.resize(5);
+  pyr.update();
+  EXPECT_EQ(pyr.level(1).size(), 1u);
+  EXPECT_EQ(pyr.level(1).back().count, 5u);
+}
+
+TEST(pyramid, sliding_window_test)
+{
+  using ns    = std::chrono::nanoseconds;
+  using buffT = std::deque<daqu::stamped_data<int, tp>>;
+
+  // every bucket summarizes exactly the samples of the queue within its stamps
+  const auto check = [](const buffT& buffer, const daqu::pyramid<buffT>& pyr) {
+    for (std::size_t l = 1; l <= pyr.levels(); ++l)
+    {
+      std::size_t total = 0;
+      for (const auto& b : pyr.level(l))
+      {
+        int         min = std::numeric_limits<int>::max(), max = std::numeric_limits<int>::lowest();
+        double      sum   = 0.;
+        std::size_t count = 0;
+        for (const auto& s : buffer)
+        {
+          if (s.ts < b.first_ts || b.last_ts < s.ts)
+            continue;
+          min = std::min(min, s.data);
+          max = std::max(max, s.data);
+          sum += s.data;
+          ++count;
+        }
+        ASSERT_EQ(b.count, count);
+        ASSERT_EQ(b.min, static_cast<float>(min));
+        ASSERT_EQ(b.max, static_cast<float>(max));
+        ASSERT_DOUBLE_EQ(b.sum, sum);
+        total += count;
+      }
+      ASSERT_EQ(total, buffer.size());
+    }
+  };
+
+  buffT                buffer;
+  daqu::pyramid<buffT> pyr(buffer, 3, 4);
+
+  std::mt19937                       gen(7);
+  std::uniform_int_distribution<int> value(-50, 50), burst(1, 9);
+  int                                i = 0;
+  for (; i < 137; ++i)
+    buffer.emplace_back(value(gen), tp{ns{i * 10}});
+  pyr.update();
+  check(buffer, pyr);
+
+  // ring buffer of constant size, a few samples per update
+  for (int step = 0; step < 300; ++step)
+  {
+    for (int n = burst(gen); n > 0; --n, ++i)
+    {
+      buffer.emplace_back(value(gen), tp{ns{i * 10}});
+      buffer.pop_front();
+    }
+    pyr.update();
+    check(buffer, pyr);
+  }
+
+  // window shrinks and grows
+  buffer.erase(buffer.begin(), buffer.begin() + 100);
+  pyr.update();
+  check(buffer, pyr);
+
+  buffer.clear();
+  pyr.update();
+  EXPECT_TRUE(pyr.level(1).empty());
+
+  for (int n = 0; n < 30; ++n, ++i)
+    buffer.emplace_back(value(gen), tp{ns{i * 10}});
+  pyr.update();
+  check(buffer, pyr);
+}
+
+TEST(storage_data_accessor, bulk_classification_test)
+{
+  using buffT = std::vector<daqu::stamped_data<int, tp>>;
+  buffT buffer;
+
+  std::vector<tp> queries;
+  for (long ts = -50; ts < 400; ts += 7)
+    queries.push_back(tp{std::chrono::nanoseconds{ts}});
+
+  std::chrono::nanoseconds thesh{20};
+
+  {
+    std::vector<std::uint64_t> mask;
+    daqu::access(buffer).in_range(queries.begin(), queries.end(), std::back_inserter(mask));
+    EXPECT_EQ(mask, (std::vector<std::uint64_t>{0, 0}));
+
+    std::vector<daqu::storage_data_accessor<buffT>::result> res;
+    daqu::access(buffer).get(queries.begin(), queries.end(), thesh, std::back_inserter(res));
+    ASSERT_EQ(res.size(), queries.size());
+    EXPECT_EQ(res.front().status, daqu::storage_access_status::not_enough_elements);
+  }
+
+  for (int i = 0; i < 30; ++i)
+    buffer.emplace_back(i, tp{std::chrono::nanoseconds{i * i / 3}});
+
+  auto check = [&]() {
+    std::vector<std::uint64_t> mask;
+    daqu::access(buffer).in_range(queries.begin(), queries.end(), std::back_inserter(mask));
+    ASSERT_EQ(mask.size(), (queries.size() + 63) / 64);
+
+    std::vector<daqu::storage_data_accessor<buffT>::result> res;
+    daqu::access(buffer).get(queries.begin(), queries.end(), thesh, std::back_inserter(res));
+    ASSERT_EQ(res.size(), queries.size());
+
+    for (std::size_t i = 0; i < queries.size(); ++i)
+    {
+      EXPECT_EQ((mask[i / 64] >> (i % 64)) & 1, daqu::access(buffer).in_range(queries[i]));
+
+      const auto single = daqu::access(buffer).get(queries[i], thesh);
+      EXPECT_EQ(res[i].it, single.it);
+      EXPECT_EQ(res[i].status, single.status);
+      EXPECT_EQ(res[i].time_diff, single.time_diff);
+    }
+  };
+
+  check();
+
+  // unsorted input falls back to a full search
+  std::swap(queries[3], queries[40]);
+  check();
+}
+
+TEST(placement, numa_buffer_and_replicas_test)
+{
+  EXPECT_GE(daqu::numa_node_count(), 1);
+  EXPECT_GE(daqu::current_numa_node(), 0);
+
+  using value_type = daqu::stamped_data<int, tp>;
+  using buffT      = std::vector<value_type, daqu::placement_allocator<value_type>>;
+
+  // node which does not exist degrades to plain pages
+  for (int node : {-1, 0, 1000})
+  {
+    buffT buffer{daqu::placement_allocator<value_type>(daqu::placement{node})};
+    for (int i = 0; i < 5000; ++i)
+      buffer.emplace_back(i, tp{std::chrono::nanoseconds{i * 3}});
+    EXPECT_EQ(buffer.get_allocator().where().numa_node, node);
+    EXPECT_EQ(daqu::access(buffer).get(tp{std::chrono::nanoseconds{301}})->data, 100);
+  }
+
+  buffT buffer;
+  for (int i = 0; i < 1000; ++i)
+    buffer.emplace_back(i, tp{std::chrono::nanoseconds{i * 3}});
+
+  daqu::timestamp_replicas<buffT> replicas(buffer, 2);
+  EXPECT_EQ(replicas.nodes(), 2u);
+  EXPECT_EQ(replicas.replica(1).size(), buffer.size());
+
+  buffer.emplace_back(1000, tp{std::chrono::nanoseconds{5000}});
+  for (long ts = -5; ts < 5005; ts += 4)
+    EXPECT_EQ(daqu::access(buffer, std::cref(replicas)).get(tp{std::chrono::nanoseconds{ts}}),
+              daqu::access(buffer).get(tp{std::chrono::nanoseconds{ts}}));
+
+  replicas.update();
+  EXPECT_EQ(replicas.replica(0).size(), buffer.size());
+  EXPECT_EQ(daqu::access(buffer, std::cref(replicas)).get(tp{std::chrono::nanoseconds{4000}})->data, 1000);
+}
+
+TEST(placement, replicas_sliding_window_test)
+{
+  using value_type = daqu::stamped_data<int, tp>;
+  using buffT      = std::deque<value_type>;
+  using ns         = std::chrono::nanoseconds;
+
+  // queue of 100 samples, every third stamp duplicated
+  buffT buffer;
+  int   i = 0;
+  for (; i < 100; ++i)
+    buffer.emplace_back(i, tp{ns{(i - i % 3 / 2) * 10}});
+
+  daqu::timestamp_replicas<buffT> replicas(buffer, 2);
+  for (; i < 3000; ++i)
+  {
+    buffer.emplace_back(i, tp{ns{(i - i % 3 / 2) * 10}});
+    buffer.pop_front();
+    // stale replicas between updates still give correct results
+    if (i % 7 != 0)
+      replicas.update();
+
+    for (long ts = buffer.front().ts.time_since_epoch().count() - 15; ts < buffer.back().ts.time_since_epoch().count() + 15; ts += 35)
+      ASSERT_EQ(daqu::access(buffer, std::cref(replicas)).get(tp{ns{ts}}), daqu::access(buffer).get(tp{ns{ts}})) << i << " " << ts;
+  }
+
+  // evicted stamps are dropped incrementally and the kept ones stay aligned with the queue
+  const auto& column = replicas.replica(0);
+  ASSERT_GE(column.size(), buffer.size());
+  ASSERT_LE(column.size(), 2 * buffer.size() + 1);
+  EXPECT_TRUE(std::equal(buffer.begin(), buffer.end(), column.end() - static_cast<std::ptrdiff_t>(buffer.size()),
+                         [](const value_type& v, const tp& ts) { return v.ts == ts; }));
+
+  // shrinking without update
+  buffer.erase(buffer.begin(), buffer.begin() + 60);
+  buffer.resize(20);
+  for (long ts = 29000; ts < 30000; ts += 7)
+    ASSERT_EQ(daqu::access(buffer, std::cref(replicas)).get(tp{ns{ts}}), daqu::access(buffer).get(tp{ns{ts}}));
+
+  replicas.update();
+  EXPECT_EQ(daqu::access(buffer, std::cref(replicas)).get(buffer[10].ts), buffer.begin() + 10 - (buffer[9].ts == buffer[10].ts));
+
+  buffer.clear();
+  replicas.update();
+  EXPECT_EQ(daqu::access(buffer, std::cref(replicas)).get(tp{ns{1}}), buffer.end());
+}
+
+TEST(placement, huge_pages_test)
+{
+  using value_type = daqu::stamped_data<int, tp>;
+  using buffT      = std::vector<value_type, daqu::placement_allocator<value_type>>;
+
+  // falls back to transparent or plain pages when no huge pages are reserved
+  for (auto pages : {daqu::huge_pages::transparent, daqu::huge_pages::explicit_2mb})
+  {
+    buffT buffer{daqu::placement_allocator<value_type>(daqu::placement{0, pages})};
+    for (int i = 0; i < 300000; ++i)
+      buffer.emplace_back(i, tp{std::chrono::nanoseconds{i * 3}});
+
+    // small growth steps come from the heap, the final capacity is a 2 MB aligned mapping
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(buffer.data()) % (std::size_t(2) << 20), 0u);
+    EXPECT_EQ(daqu::access(buffer, daqu::prefetch_search()).get(tp{std::chrono::nanoseconds{301}})->data, 100);
+    EXPECT_EQ(daqu::access(buffer, daqu::prefetch_search()).get(tp{std::chrono::nanoseconds{-1}})->data, 0);
+    EXPECT_EQ(daqu::access(buffer, daqu::prefetch_search()).get(tp{std::chrono::nanoseconds{900000}})->data, 299999);
+  }
+
+  buffT empty;
+  EXPECT_EQ(daqu::access(empty, daqu::prefetch_search()).get(tp{std::chrono::nanoseconds{1}}), empty.end());
+}
+
+TEST(replayer, merge_order_and_pace_test)
+{
+  using value_type = daqu::stamped_data<int, tp>;
+  using ns         = std::chrono::nanoseconds;
+
+  // records stream (sign) and stamp of everything published
+  struct merged_log
+  {
+    void push_back(const value_type& v) { log.emplace_back(sign * v.data, v.ts); }
+
+    int                              sign;
+    std::vector<std::pair<int, tp>>& log;
+  };
+
+  std::vector<value_type> a, b;
+  for (int i = 1; i <= 100; ++i)
+    a.emplace_back(i, tp{ns{i * 2'000'000}});
+  for (int i = 1; i <= 50; ++i)
+    b.emplace_back(i, tp{ns{i * 3'000'000}});
+
+  const std::string path = ::testing::TempDir() + "data_queue_replay.bin";
+  ASSERT_EQ(daqu::save_checkpoint(b, path), daqu::checkpoint_status::success);
+
+  std::vector<std::pair<int, tp>> log;
+  merged_log                      live_a{1, log}, live_b{-1, log};
+
+  {
+    daqu::replayer<tp> replay;
+    replay.add_stream(a, live_a);
+    EXPECT_EQ(replay.add_stream<std::vector<value_type>>(path + ".missing", live_b), daqu::checkpoint_status::io_error);
+    EXPECT_EQ(replay.add_stream<std::vector<value_type>>(path, live_b), daqu::checkpoint_status::success);
+    EXPECT_EQ(replay.run(), 150u);
+  }
+
+  ASSERT_EQ(log.size(), 150u);
+  EXPECT_TRUE(std::is_sorted(log.begin(), log.end(), [](const auto& l, const auto& r) { return l.second < r.second; }));
+  // equal stamps keep order of streams, a before b
+  for (std::size_t i = 1; i < log.size(); ++i)
+  {
+    if (log[i].second == log[i - 1].second)
+    {
+      EXPECT_TRUE(log[i - 1].first > 0 && log[i].first < 0);
+    }
+  }
+
+  // 200 ms of recording at 4x speed
+  {
+    std::vector<value_type> live;
+    daqu::replayer<tp>      replay(daqu::replay_mode::scaled, 4.);
+    replay.add_stream(a, live);
+
+    const auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(replay.run(), 100u);
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_GE(elapsed, std::chrono::milliseconds{49});
+    ASSERT_EQ(live.size(), a.size());
+    EXPECT_EQ(live.back().ts, a.back().ts);
+
+    // runs again from the start
+    EXPECT_EQ(replay.run(), 100u);
+    EXPECT_EQ(live.size(), 200u);
+  }
+
+  // stop before run is not lost, it ends that run only
+  {
+    std::vector<value_type> live;
+    daqu::replayer<tp>      replay;
+    replay.add_stream(a, live);
+    replay.stop();
+    EXPECT_EQ(replay.run(), 0u);
+    EXPECT_EQ(replay.run(), 100u);
+  }
+
+  EXPECT_THROW(daqu::replayer<tp>(daqu::replay_mode::scaled, 0.), std::invalid_argument);
+  EXPECT_THROW(daqu::replayer<tp>(daqu::replay_mode::scaled, -2.), std::invalid_argument);
+}
+
+TEST(storage_data_accessor, copy_free_interpolation_test)
+{
+  using value_type = daqu::stamped_data<std::string, tp>;
+  using ns         = std::chrono::nanoseconds;
+
+  std::vector<value_type> buffer;
+  buffer.emplace_back("one", tp{ns{10}});
+  buffer.emplace_back("two", tp{ns{20}});
+  buffer.emplace_back("three", tp{ns{30}});
+
+  auto accessor = daqu::access(buffer);
+  auto pick     = [](const value_type& l, float w0, const value_type& r, float, const tp& ts) { return value_type(w0 < .5f ? l.data : r.data, ts); };
+
+  // exact hit and clamp reference the stored sample
+  auto exact = accessor.get_data_ref(accessor.get(tp{ns{20}}), tp{ns{20}}, pick);
+  EXPECT_FALSE(exact.interpolated());
+  EXPECT_EQ(&exact.get(), &buffer[1]);
+  EXPECT_EQ(&accessor.get_data_ref(accessor.get(tp{ns{40}}), tp{ns{40}}, pick).get(), &buffer[2]);
+  EXPECT_EQ(&*accessor.get_data_ref(accessor.get(tp{ns{0}}), tp{ns{0}}, pick), &buffer[0]);
+
+  auto inter = accessor.get_data_ref(accessor.get(tp{ns{27}}), tp{ns{27}}, pick);
+  EXPECT_TRUE(inter.interpolated());
+  EXPECT_EQ(inter->data, "three");
+  EXPECT_EQ(inter->ts, tp{ns{27}});
+
+  // out keeps its capacity when the functor writes into it
+  auto concat = [](const value_type& l, float, const value_type& r, float, const tp& ts, value_type& out) {
+    out.data.assign(l.data).append(r.data);
+    out.ts = ts;
+  };
+
+  value_type out{std::string(64, ' '), tp{}};
+  const auto capacity = out.data.capacity();
+
+  EXPECT_EQ(&accessor.get_data_inter_into(accessor.get(tp{ns{10}}), tp{ns{10}}, out, concat), &buffer[0]);
+  const value_type& res = accessor.get_data_inter_into(accessor.get(tp{ns{14}}), tp{ns{14}}, out, concat);
+  EXPECT_EQ(&res, &out);
+  EXPECT_EQ(res.data, "onetwo");
+  EXPECT_EQ(res.ts, tp{ns{14}});
+  EXPECT_EQ(out.data.capacity(), capacity);
+
+  // five argument functors are assigned
+  EXPECT_EQ(accessor.get_data_inter_into(accessor.get(tp{ns{26}}), tp{ns{26}}, out, pick).data, "three");
+  EXPECT_EQ(accessor.get_data_inter_into(accessor.get(tp{ns{24}}), tp{ns{24}}, out, pick).data,
+            accessor.get_data_inter(accessor.get(tp{ns{24}}), tp{ns{24}}, pick).data);
+}